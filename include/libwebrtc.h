@@ -38,11 +38,22 @@ class LibWebRTC {
    * RTCPeerConnectionFactoryImpl class and initializes it.
    *
    * @return A scoped_refptr object that points to the newly created
-   * RTCPeerConnectionFactory.
+   * RTCPeerConnectionFactory, or nullptr if it failed to initialize.
    */
   LIB_WEBRTC_API static scoped_refptr<RTCPeerConnectionFactory>
   CreateRTCPeerConnectionFactory();
 
+  /**
+   * @brief Creates a new WebRTC PeerConnectionFactory with the given options.
+   *
+   * @return A scoped_refptr object that points to the newly created
+   * RTCPeerConnectionFactory, or nullptr if it failed to initialize, e.g.
+   * because thread options could not be applied.
+   */
+  LIB_WEBRTC_API static scoped_refptr<RTCPeerConnectionFactory>
+  CreateRTCPeerConnectionFactory(
+      const RTCPeerConnectionFactoryOptions& options);
+
   /**
    * @brief Terminates the WebRTC PeerConnectionFactory and threads.
    *
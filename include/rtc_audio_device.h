@@ -14,6 +14,23 @@ class RTCAudioDevice : public RefCountInterface {
  public:
   typedef fixed_size_function<void()> OnDeviceChangeCallback;
 
+  typedef fixed_size_function<void(int32_t result, const string name,
+                                   const string guid)>
+      OnDeviceNameCallback;
+
+  typedef fixed_size_function<void(int32_t result, uint32_t volume)>
+      OnVolumeCallback;
+
+  typedef fixed_size_function<void(int32_t result)> OnResultCallback;
+
+  /**
+   * Name and GUID of an audio device, as reported by the ADM.
+   */
+  struct DeviceInfo {
+    string name;
+    string guid;
+  };
+
  public:
   static const int kAdmMaxDeviceNameSize = 128;
   static const int kAdmMaxFileNameSize = 512;
@@ -90,6 +107,53 @@ class RTCAudioDevice : public RefCountInterface {
 
   virtual int32_t SpeakerVolume(uint32_t& volume) = 0;
 
+  /**
+   * Returns the cached list of playout devices. The list is refreshed on the
+   * worker thread whenever the devices change, so this call never blocks on
+   * the worker thread.
+   *
+   * @return vector<DeviceInfo> - The playout devices, in index order.
+   */
+  virtual vector<DeviceInfo> PlayoutDeviceList() = 0;
+
+  /**
+   * Returns the cached list of recording devices. See PlayoutDeviceList().
+   *
+   * @return vector<DeviceInfo> - The recording devices, in index order.
+   */
+  virtual vector<DeviceInfo> RecordingDeviceList() = 0;
+
+  /**
+   * Non-blocking variants of the calls above. The work is posted to the
+   * worker thread and the callback is invoked there with the result.
+   */
+  virtual void PlayoutDeviceNameAsync(uint16_t index,
+                                      OnDeviceNameCallback callback) = 0;
+
+  virtual void RecordingDeviceNameAsync(uint16_t index,
+                                        OnDeviceNameCallback callback) = 0;
+
+  virtual void SetMicrophoneVolumeAsync(uint32_t volume,
+                                        OnResultCallback callback) = 0;
+
+  virtual void MicrophoneVolumeAsync(OnVolumeCallback callback) = 0;
+
+  virtual void SetSpeakerVolumeAsync(uint32_t volume,
+                                     OnResultCallback callback) = 0;
+
+  virtual void SpeakerVolumeAsync(OnVolumeCallback callback) = 0;
+
+  /**
+   * Retrieves the effective playout latency and the underrun counter.
+   * Values the platform cannot report are set to -1.
+   *
+   * @param playout_delay_ms - The current playout delay in milliseconds.
+   * @param playout_underruns - The number of playout underruns so far.
+   * @return int32_t - 0 if successful, otherwise an error code.
+   */
+  virtual int32_t GetLatencyStats(int32_t& playout_delay_ms,
+                                  int32_t& playout_underruns) = 0;
+
  protected:
   virtual ~RTCAudioDevice() {}
 };
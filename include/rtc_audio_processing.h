@@ -22,14 +22,59 @@ class RTCAudioProcessing : public RefCountInterface {
     virtual ~CustomProcessing() {}
   };
 
- public:
+  enum class EchoCancellerMode { kDisabled, kMobile, kFull };
+
+  enum class NoiseSuppressionLevel {
+    kDisabled,
+    kLow,
+    kModerate,
+    kHigh,
+    kVeryHigh
+  };
+
+  enum class GainControlMode {
+    kDisabled,
+    kAdaptiveAnalog,
+    kAdaptiveDigital,
+    kFixedDigital
+  };
+
+  // Typed subset of webrtc::AudioProcessing::Config. Stages that are not
+  // needed (e.g. hardware AEC, server side ingest) can be disabled so the
+  // APM does not spend cycles on them. Defaults match the native config;
+  // until ApplyConfig() is called the voice engine turns AEC, NS, AGC and
+  // the high pass filter on when audio starts.
+  struct Config {
+    EchoCancellerMode echo_canceller = EchoCancellerMode::kDisabled;
+    NoiseSuppressionLevel noise_suppression =
+        NoiseSuppressionLevel::kDisabled;
+    GainControlMode gain_control = GainControlMode::kDisabled;
+    // Adaptive digital gain controller, applied after |gain_control|.
+    bool gain_controller2 = false;
+    bool high_pass_filter = false;
+    // Maximum internal processing rate in Hz, 0 keeps the current rate.
+    int pipeline_max_processing_rate = 48000;
+    bool multi_channel_render = false;
+    bool multi_channel_capture = false;
+  };
+
   virtual void SetCapturePostProcessing(
       CustomProcessing* capture_post_processing) = 0;
 
   virtual void SetRenderPreProcessing(
       CustomProcessing* render_pre_processing) = 0;
+
+  virtual void SetCapturePostProcessingBypass(bool bypass) = 0;
+
+  virtual void SetRenderPreProcessingBypass(bool bypass) = 0;
+
+  // Applies the config to the running APM, takes effect on the next
+  // processed frame.
+  virtual void ApplyConfig(const Config& config) = 0;
+
+  virtual Config GetConfig() = 0;
 };
 
 }  // namespace libwebrtc
 
-#endif  // LIB_WEBRTC_RTC_AUDIO_PROCESSING_HXX
\ No newline at end of file
+#endif  // LIB_WEBRTC_RTC_AUDIO_PROCESSING_HXX
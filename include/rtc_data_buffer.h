@@ -0,0 +1,58 @@
+#ifndef LIB_WEBRTC_RTC_DATA_BUFFER_HXX
+#define LIB_WEBRTC_RTC_DATA_BUFFER_HXX
+
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+/**
+ * The RTCDataBuffer class is a refcounted, copy-on-write byte buffer that can
+ * be passed across the library boundary. Handing it to
+ * RTCDataChannel::Send() shares the underlying storage with the SCTP send
+ * queue instead of copying it; the storage is released once every holder,
+ * including the send queue, has dropped its reference.
+ */
+class RTCDataBuffer : public RefCountInterface {
+ public:
+  /**
+   * Creates a buffer of the given size, to be filled in place through
+   * MutableData().
+   */
+  LIB_WEBRTC_API static scoped_refptr<RTCDataBuffer> Create(size_t size,
+                                                           bool binary = true);
+
+  /**
+   * Creates a buffer holding a copy of the given bytes.
+   */
+  LIB_WEBRTC_API static scoped_refptr<RTCDataBuffer> Create(
+      const uint8_t* data, size_t size, bool binary = true);
+
+ public:
+  /**
+   * Returns a read-only pointer to the buffer contents.
+   */
+  virtual const uint8_t* data() const = 0;
+
+  /**
+   * Returns a writable pointer to the buffer contents. If the storage is
+   * still shared (e.g. queued for sending), it is copied first.
+   */
+  virtual uint8_t* MutableData() = 0;
+
+  /**
+   * Returns the size of the buffer in bytes.
+   */
+  virtual size_t size() const = 0;
+
+  /**
+   * Returns whether the buffer carries binary or text data.
+   */
+  virtual bool binary() const = 0;
+
+ protected:
+  virtual ~RTCDataBuffer() {}
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_DATA_BUFFER_HXX
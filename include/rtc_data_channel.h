@@ -1,6 +1,7 @@
 #ifndef LIB_WEBRTC_RTC_DATA_CHANNEL_HXX
 #define LIB_WEBRTC_RTC_DATA_CHANNEL_HXX
 
+#include "rtc_data_buffer.h"
 #include "rtc_types.h"
 
 namespace libwebrtc {
@@ -34,6 +35,53 @@ struct RTCDataChannelInit {
   int id = 0;
 };
 
+/**
+ * The RTCDataChannelOverflowPolicy enum selects what happens when the
+ * delivery queue of a data channel is full. kBuffer keeps the messages that
+ * do not fit in an overflow list behind the queue, so the network thread,
+ * shared by every connection of the factory, never waits for the observer.
+ * The list holds up to 64 MiB of messages per channel; once it is full,
+ * incoming messages are discarded and counted in dropped_messages, so a
+ * stalled observer can't exhaust memory. kDropNewest discards the incoming
+ * message as soon as the queue is full and is meant for unreliable
+ * channels.
+ */
+enum class RTCDataChannelOverflowPolicy {
+  kBuffer,
+  kDropNewest,
+};
+
+/**
+ * The RTCDataChannelDeliveryStats struct reports the state of the delivery
+ * queue enabled with RTCDataChannel::EnableDeliveryQueue() or
+ * RTCDataChannel::EnablePolling().
+ */
+struct RTCDataChannelDeliveryStats {
+  // Queued messages, including the ones held in the overflow list.
+  uint32_t queue_depth = 0;
+  uint32_t max_queue_depth = 0;
+  uint64_t delivered_messages = 0;
+  // Messages discarded by kDropNewest or because the overflow list was
+  // full.
+  uint64_t dropped_messages = 0;
+  // Messages that found the queue full and went to the overflow list, a
+  // growing value means the observer does not keep up.
+  uint64_t overflowed_messages = 0;
+  int64_t average_delivery_latency_us = 0;
+  int64_t max_delivery_latency_us = 0;
+};
+
+/**
+ * The RTCDataChannelTrafficStats struct holds the message and byte counters
+ * of a data channel, or the sum over all data channels of a peer connection.
+ */
+struct RTCDataChannelTrafficStats {
+  uint64_t messages_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t messages_received = 0;
+  uint64_t bytes_received = 0;
+};
+
 /**
  * The RTCDataChannelObserver class is an interface for receiving events related
  * to a WebRTC data channel. These events include changes in the channel's state
@@ -54,6 +102,34 @@ class RTCDataChannelObserver {
    */
   virtual void OnMessage(const char* buffer, int length, bool binary) = 0;
 
+  /**
+   * Returns true if messages should be delivered through OnMessageBuffer()
+   * instead of OnMessage().
+   */
+  virtual bool ReceivesMessageBuffers() { return false; }
+
+  /**
+   * Called when a message is received and ReceivesMessageBuffers() returns
+   * true. The buffer shares the received payload without copying it and may
+   * be retained and handed to another thread after the callback returns.
+   */
+  virtual void OnMessageBuffer(scoped_refptr<RTCDataBuffer> buffer) {}
+
+  /**
+   * Called when the buffered amount decreases because queued data was handed
+   * to the transport. The number of bytes sent is passed as a parameter.
+   */
+  virtual void OnBufferedAmountChange(uint64_t sent_data_size) {}
+
+  /**
+   * Called when the buffered amount drops from above the threshold set with
+   * RTCDataChannel::SetBufferedAmountLowThreshold() to at or below it, and
+   * once when the threshold is raised to or above a buffered amount that
+   * exceeded the previous threshold. The current buffered amount is passed
+   * as a parameter.
+   */
+  virtual void OnBufferedAmountLow(uint64_t buffered_amount) {}
+
  protected:
   /**
    * The destructor for the RTCDataChannelObserver class.
@@ -69,6 +145,10 @@ class RTCDataChannelObserver {
  */
 class RTCDataChannel : public RefCountInterface {
  public:
+  typedef fixed_size_function<void(const uint8_t* data, size_t size,
+                                   bool binary)>
+      OnPolledMessage;
+
   /**
    * Sends data over the data channel.
    * The data buffer, its size, and a boolean indicating whether the data is
@@ -77,6 +157,27 @@ class RTCDataChannel : public RefCountInterface {
   virtual void Send(const uint8_t* data, uint32_t size,
                     bool binary = false) = 0;
 
+  /**
+   * Sends a refcounted buffer over the data channel without copying it.
+   * The buffer storage is shared with the send queue and released once the
+   * message has been handed to the transport. A null buffer is ignored.
+   */
+  virtual void Send(scoped_refptr<RTCDataBuffer> buffer) = 0;
+
+  /**
+   * Sends a batch of messages with a single hop to the network thread,
+   * instead of one hop per message.
+   *
+   * @param messages - The messages to send, in order.
+   * @param buffered_amount - Set to the buffered amount after the batch has
+   * been queued.
+   * @return vector<bool> - Per-message result, false if the message was
+   * rejected (e.g. channel not open or send buffer full).
+   */
+  virtual vector<bool> SendBatch(
+      const vector<scoped_refptr<RTCDataBuffer>> messages,
+      uint64_t& buffered_amount) = 0;
+
   /**
    * Closes the data channel.
    */
@@ -110,6 +211,74 @@ class RTCDataChannel : public RefCountInterface {
    */
   virtual uint64_t buffered_amount() const = 0;
 
+  /**
+   * Sets the low-watermark used to fire
+   * RTCDataChannelObserver::OnBufferedAmountLow().
+   */
+  virtual void SetBufferedAmountLowThreshold(uint64_t threshold) = 0;
+
+  /**
+   * Returns the current low-watermark of the buffered amount.
+   */
+  virtual uint64_t buffered_amount_low_threshold() const = 0;
+
+  /**
+   * Moves observer callbacks off the network thread. Received messages are
+   * pushed into a bounded queue and delivered, together with the other
+   * observer events, on a dedicated thread owned by this channel, so a slow
+   * observer no longer stalls networking for the whole peer connection.
+   * Once enabled the mode stays on for the lifetime of the channel.
+   *
+   * @param capacity - The maximum number of queued messages.
+   * @param policy - What to do when the queue is full.
+   */
+  virtual void EnableDeliveryQueue(uint32_t capacity,
+                                   RTCDataChannelOverflowPolicy policy) = 0;
+
+  /**
+   * Returns queue depth, drop and delivery latency counters of the delivery
+   * queue. All values are zero if the queue is not enabled.
+   */
+  virtual RTCDataChannelDeliveryStats delivery_stats() const = 0;
+
+  /**
+   * Switches message delivery to pull mode. Received messages are pushed
+   * into a lock-free bounded queue straight from the network thread and are
+   * read with Drain() instead of RTCDataChannelObserver::OnMessage(), e.g.
+   * once per frame of a simulation loop. The observer still receives the
+   * other events, now on the network thread, so keep them short.
+   * Has no effect if the delivery queue is enabled.
+   *
+   * @param capacity - The maximum number of queued messages.
+   * @param policy - What to do when the queue is full.
+   */
+  virtual void EnablePolling(uint32_t capacity,
+                             RTCDataChannelOverflowPolicy policy) = 0;
+
+  /**
+   * Reads up to |max_messages| queued messages and passes each one to
+   * |callback| on the calling thread. The data pointer is only valid during
+   * the callback. Drain() must not be called from more than one thread at a
+   * time.
+   *
+   * @return uint32_t - The number of messages read.
+   */
+  virtual uint32_t Drain(uint32_t max_messages, OnPolledMessage callback) = 0;
+
+  /**
+   * Moves up to |max_messages| queued messages into |messages| without
+   * copying their payload.
+   *
+   * @return uint32_t - The number of messages stored in |messages|.
+   */
+  virtual uint32_t Drain(scoped_refptr<RTCDataBuffer>* messages,
+                         uint32_t max_messages) = 0;
+
+  /**
+   * Returns the number of messages and bytes sent and received.
+   */
+  virtual RTCDataChannelTrafficStats traffic_stats() const = 0;
+
   /**
    * Returns the state of the data channel.
    */
@@ -0,0 +1,139 @@
+#ifndef LIB_WEBRTC_RTC_DATA_TRANSFER_HXX
+#define LIB_WEBRTC_RTC_DATA_TRANSFER_HXX
+
+#include "rtc_data_channel.h"
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+/**
+ * Set in the ids of incoming transfers, so they never collide with the ids
+ * of outgoing transfers, which are assigned independently by each peer.
+ */
+const uint32_t kIncomingTransferIdBit = 0x80000000u;
+
+/**
+ * The RTCDataTransferOptions struct configures chunking and flow control of
+ * an RTCDataTransfer.
+ */
+struct RTCDataTransferOptions {
+  // Payload bytes per data channel message.
+  uint32_t chunk_size = 64 * 1024;
+  // Upper bound of the data channel buffered amount. Sending pauses once it
+  // is reached and resumes on the next buffered amount change that leaves
+  // room below it, every drain of the channel tops the window up again.
+  uint64_t window_size = 1024 * 1024;
+  // Minimum number of bytes between two OnProgress() calls.
+  uint64_t progress_interval = 1024 * 1024;
+};
+
+/**
+ * The RTCDataTransferSink class receives the chunks of an incoming transfer.
+ * Chunks arrive in order on reliable ordered channels, the offset allows
+ * sinks to write positionally otherwise.
+ */
+class RTCDataTransferSink {
+ public:
+  /**
+   * Writes a chunk at the given offset. Returning false aborts the transfer.
+   */
+  virtual bool Write(uint64_t offset, const uint8_t* data, size_t size) = 0;
+
+  /**
+   * Called once when the transfer finished or failed. No other method is
+   * called afterwards.
+   */
+  virtual void Close(bool success) = 0;
+
+ protected:
+  virtual ~RTCDataTransferSink() {}
+};
+
+/**
+ * The RTCDataTransferObserver class is notified about incoming transfers,
+ * progress and completion.
+ */
+class RTCDataTransferObserver {
+ public:
+  /**
+   * Called when the remote side starts a transfer. Returns the sink to
+   * reassemble into, or nullptr to reject the transfer.
+   */
+  virtual RTCDataTransferSink* OnIncomingTransfer(uint32_t transfer_id,
+                                                  const string name,
+                                                  uint64_t size) = 0;
+
+  /**
+   * Called as bytes are sent or received.
+   */
+  virtual void OnProgress(uint32_t transfer_id, bool incoming,
+                          uint64_t transferred, uint64_t size) = 0;
+
+  /**
+   * Called when a transfer completes or fails.
+   */
+  virtual void OnComplete(uint32_t transfer_id, bool incoming,
+                          bool success) = 0;
+
+ protected:
+  virtual ~RTCDataTransferObserver() {}
+};
+
+/**
+ * The RTCDataTransfer class streams arbitrarily large payloads over a data
+ * channel. Payloads are split into chunks, sending is windowed on the
+ * channel's buffered amount, and the receiving side writes chunks straight
+ * into a sink, so memory use stays constant regardless of the payload size.
+ *
+ * The transfer takes over the observer of the channel it is created on, so
+ * it should be given a dedicated, reliable data channel.
+ */
+class RTCDataTransfer : public RefCountInterface {
+ public:
+  LIB_WEBRTC_API static scoped_refptr<RTCDataTransfer> Create(
+      scoped_refptr<RTCDataChannel> data_channel,
+      RTCDataTransferObserver* observer,
+      const RTCDataTransferOptions& options = RTCDataTransferOptions());
+
+  /**
+   * Creates a sink that writes into the file at |path|, truncating it. The
+   * sink deletes itself on Close(). Returns nullptr if the file cannot be
+   * opened.
+   */
+  LIB_WEBRTC_API static RTCDataTransferSink* CreateFileSink(const string path);
+
+ public:
+  /**
+   * Queues the file at |path| for sending.
+   *
+   * @return uint32_t - The transfer id, 0 if the file cannot be opened.
+   */
+  virtual uint32_t SendFile(const string path, const string name) = 0;
+
+  /**
+   * Queues an in-memory payload for sending. |data| must stay valid until
+   * OnComplete() is called for the returned transfer id.
+   *
+   * @return uint32_t - The transfer id.
+   */
+  virtual uint32_t SendData(const uint8_t* data, uint64_t size,
+                            const string name) = 0;
+
+  /**
+   * Aborts an outgoing transfer, or an incoming one if |transfer_id| has
+   * kIncomingTransferIdBit set.
+   */
+  virtual void Cancel(uint32_t transfer_id) = 0;
+
+  /**
+   * Stops all transfers and releases the data channel observer.
+   */
+  virtual void Close() = 0;
+
+ protected:
+  virtual ~RTCDataTransfer() {}
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_DATA_TRANSFER_HXX
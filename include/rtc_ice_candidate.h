@@ -5,6 +5,12 @@
 
 namespace libwebrtc {
 
+struct RTCIceCandidateInit {
+  string candidate;
+  string sdp_mid;
+  int sdp_mline_index = 0;
+};
+
 class RTCIceCandidate : public RefCountInterface {
  public:
   static LIB_WEBRTC_API scoped_refptr<RTCIceCandidate> Create(
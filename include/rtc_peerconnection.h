@@ -129,6 +129,31 @@ typedef fixed_size_function<void(const string sdp, const string type)>
 
 typedef fixed_size_function<void(const char* erro)> OnSdpCreateFailure;
 
+// Limits of the bandwidth estimate of the whole connection, -1 keeps the
+// current value.
+struct RTCBitrateSettings {
+  int min_bitrate_bps = -1;
+  // Initial estimate. Starting high avoids the slow ramp-up on good networks.
+  int start_bitrate_bps = -1;
+  int max_bitrate_bps = -1;
+};
+
+// Typed counterpart of the offer/answer constraints, maps directly to
+// webrtc::PeerConnectionInterface::RTCOfferAnswerOptions.
+struct RTCOfferAnswerOptions {
+  enum { kUndefined = -1, kMaxOfferToReceiveMedia = 1 };
+
+  // kUndefined follows the transceivers, 0 or 1 requests a receive-only
+  // m-line of that kind (Plan B semantics).
+  int offer_to_receive_audio = kUndefined;
+  int offer_to_receive_video = kUndefined;
+  bool voice_activity_detection = true;
+  bool ice_restart = false;
+  bool use_rtp_mux = true;
+  bool raw_packetization_for_video = false;
+  int num_simulcast_layers = 1;
+};
+
 typedef fixed_size_function<void()> OnSetSdpSuccess;
 
 typedef fixed_size_function<void(const char* error)> OnSetSdpFailure;
@@ -138,6 +163,11 @@ typedef fixed_size_function<void(const char* sdp, const char* type)>
 
 typedef fixed_size_function<void(const char* error)> OnGetSdpFailure;
 
+// One result per candidate passed to RTCPeerConnection::AddCandidates(), in
+// the same order. Candidates that fail to parse report kSyntaxError.
+typedef fixed_size_function<void(const vector<RTCErrorType> results)>
+    OnAddCandidatesComplete;
+
 class RTCPeerConnectionObserver {
  public:
   virtual void OnSignalingState(RTCSignalingState state) = 0;
@@ -150,6 +180,15 @@ class RTCPeerConnectionObserver {
 
   virtual void OnIceCandidate(scoped_refptr<RTCIceCandidate> candidate) = 0;
 
+  // Batches of local candidates when RTCConfiguration::
+  // ice_candidate_batch_window_ms is set. Forwards to OnIceCandidate() unless
+  // overridden.
+  virtual void OnIceCandidates(
+      vector<scoped_refptr<RTCIceCandidate>> candidates) {
+    for (size_t i = 0; i < candidates.size(); i++)
+      OnIceCandidate(candidates[i]);
+  }
+
   virtual void OnAddStream(scoped_refptr<RTCMediaStream> stream) = 0;
 
   virtual void OnRemoveStream(scoped_refptr<RTCMediaStream> stream) = 0;
@@ -181,6 +220,20 @@ class RTCPeerConnection : public RefCountInterface {
   virtual scoped_refptr<RTCDataChannel> CreateDataChannel(
       const string label, RTCDataChannelInit* dataChannelDict) = 0;
 
+  // Data channels created or received on this connection, looked up by SCTP
+  // stream id or label. Closed channels are dropped from the registry.
+  virtual scoped_refptr<RTCDataChannel> GetDataChannelById(int id) = 0;
+
+  virtual scoped_refptr<RTCDataChannel> GetDataChannelByLabel(
+      const string label) = 0;
+
+  virtual vector<scoped_refptr<RTCDataChannel>> data_channels() = 0;
+
+  virtual void CloseDataChannels() = 0;
+
+  // Sum over all data channels of this connection, including closed ones.
+  virtual RTCDataChannelTrafficStats data_channel_traffic_stats() = 0;
+
   virtual void CreateOffer(OnSdpCreateSuccess success,
                            OnSdpCreateFailure failure,
                            scoped_refptr<RTCMediaConstraints> constraints) = 0;
@@ -189,8 +242,20 @@ class RTCPeerConnection : public RefCountInterface {
                             OnSdpCreateFailure failure,
                             scoped_refptr<RTCMediaConstraints> constraints) = 0;
 
+  // Same as above without converting and parsing constraint strings.
+  virtual void CreateOffer(OnSdpCreateSuccess success,
+                           OnSdpCreateFailure failure,
+                           const RTCOfferAnswerOptions& options) = 0;
+
+  virtual void CreateAnswer(OnSdpCreateSuccess success,
+                            OnSdpCreateFailure failure,
+                            const RTCOfferAnswerOptions& options) = 0;
+
   virtual void RestartIce() = 0;
 
+  // Changes the bandwidth estimate limits without renegotiation.
+  virtual RTCErrorType SetBitrate(const RTCBitrateSettings& settings) = 0;
+
   virtual void Close() = 0;
 
   virtual void SetLocalDescription(const string sdp, const string type,
@@ -201,6 +266,17 @@ class RTCPeerConnection : public RefCountInterface {
                                     OnSetSdpSuccess success,
                                     OnSetSdpFailure failure) = 0;
 
+  // Apply a description parsed once with RTCSessionDescription::Create(),
+  // e.g. the same offer fanned out to many connections. Each call applies a
+  // copy of the parsed description, |description| itself is not modified.
+  virtual void SetLocalDescription(
+      scoped_refptr<RTCSessionDescription> description,
+      OnSetSdpSuccess success, OnSetSdpFailure failure) = 0;
+
+  virtual void SetRemoteDescription(
+      scoped_refptr<RTCSessionDescription> description,
+      OnSetSdpSuccess success, OnSetSdpFailure failure) = 0;
+
   virtual void GetLocalDescription(OnGetSdpSuccess success,
                                    OnGetSdpFailure failure) = 0;
 
@@ -210,6 +286,14 @@ class RTCPeerConnection : public RefCountInterface {
   virtual void AddCandidate(const string mid, int mid_mline_index,
                             const string candiate) = 0;
 
+  // Parses all candidates on the calling thread and applies them with a
+  // single hop to the signaling thread. |callback| runs on the signaling
+  // thread once every candidate has been applied or rejected, also when
+  // none parsed or the connection is closed, and never before this call
+  // returns.
+  virtual void AddCandidates(const vector<RTCIceCandidateInit> candidates,
+                             OnAddCandidatesComplete callback) = 0;
+
   virtual void RegisterRTCPeerConnectionObserver(
       RTCPeerConnectionObserver* observer) = 0;
 
@@ -264,6 +348,9 @@ class RTCPeerConnection : public RefCountInterface {
 
   virtual RTCIceGatheringState ice_gathering_state() = 0;
 
+  // Empty unless RTCConfiguration::trace_connection_setup is set.
+  virtual RTCSetupTimeline setup_timeline() = 0;
+
  protected:
   virtual ~RTCPeerConnection() {}
 };
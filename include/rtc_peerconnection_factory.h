@@ -20,8 +20,172 @@ class RTCAudioProcessing;
 class RTCVideoDevice;
 class RTCRtpCapabilities;
 
+enum class RTCThreadSchedulingPolicy {
+  kDefault,  // Leave the scheduling policy untouched.
+  kFifo,
+  kRoundRobin,
+};
+
+// Applied on the thread itself right after it starts. Settings the platform
+// does not support, or the process is not allowed to use, are logged. For
+// the network, worker and signaling threads they make
+// RTCPeerConnectionFactory::Initialize() fail, and
+// LibWebRTC::CreateRTCPeerConnectionFactory() return nullptr. Desktop
+// capture threads log them and run with the settings that could be applied.
+struct RTCThreadOptions {
+  // Thread name, empty keeps the built-in one.
+  string name;
+  // Nice value on POSIX, mapped to a thread priority level on Windows.
+  int nice = 0;
+  // kFifo and kRoundRobin map to SCHED_FIFO/SCHED_RR with |priority|, or to
+  // a time critical thread on Windows. |priority| must be within the
+  // policy's range, 1..99 on Linux; 0 selects the lowest.
+  RTCThreadSchedulingPolicy policy = RTCThreadSchedulingPolicy::kDefault;
+  int priority = 0;
+  // Bit i allows the thread to run on CPU i, 0 leaves the affinity alone.
+  uint64_t cpu_mask = 0;
+};
+
+struct RTCPeerConnectionFactoryOptions {
+  // Number of network/worker thread groups data-only peer connections are
+  // spread across. Every group beyond the first runs its own native factory
+  // with a dummy audio device and no audio processing, so connections there
+  // have no audio, and tracks from CreateAudioSource()/CreateVideoSource()
+  // belong to the first group. Only connections created with
+  // RTCConfiguration::use_network_shard are placed on additional groups.
+  uint32_t network_shards = 1;
+
+  // Default local port range for ICE sockets of every connection, so that
+  // server deployments only need to open this range in the firewall. Each
+  // connection takes one port per interface and transport, size the range
+  // for the expected number of connections. 0 lets the OS choose.
+  uint16_t min_port = 0;
+  uint16_t max_port = 0;
+
+  // One UDP socket per local address bound to this port, shared by all
+  // connections of the first thread group, 0 gives every connection sockets
+  // of its own. Connectivity checks are routed to a connection by the ICE
+  // ufrag in their USERNAME, other packets by the remote address last
+  // validated by a check, so a remote address can only talk to one
+  // connection at a time. Connections on the shared port gather host
+  // candidates only: no server reflexive, relayed or TCP candidates, and
+  // ice_servers of the configuration are not used for gathering. The port
+  // range above does not apply to them. Connections created with
+  // RTCConfiguration::use_network_shard on additional groups keep sockets
+  // of their own.
+  uint16_t shared_udp_port = 0;
+
+  // Announces a=ice-lite in local offers and answers so that clients take
+  // the controlling role and nominate the pair, and gathers host candidates
+  // only. Meant for servers with a public address, typically together with
+  // shared_udp_port. The connection still answers and sends checks like a
+  // controlled full agent.
+  bool ice_lite = false;
+
+  // Send and receive buffer sizes in bytes of RTP sockets, 0 keeps the
+  // native 256 KiB. The native stack reads them from field trials when a
+  // video channel is created, so they apply to the whole process and to
+  // every transport bundled with video. Only the first factory initialized
+  // in the process installs them, sizes of later factories are ignored.
+  // Field trials set by the application for the same sizes take precedence.
+  int udp_send_buffer_size = 0;
+  int udp_receive_buffer_size = 0;
+
+  // SCTP association tuning of data channels, 0 keeps the native default.
+  // The native transport factory is shared by all connections of a thread
+  // group, so these apply to every connection of the factory.
+  // Bytes each data channel may queue in SCTP. The native data channel also
+  // stops accepting sends above 16 MiB buffered, larger values don't lift
+  // that limit.
+  uint32_t sctp_send_queue_limit = 0;
+  // Receive window in bytes announced to the peer, native 5 MiB. Also the
+  // upper bound of RTCConfiguration::sctp_max_message_size.
+  uint32_t sctp_receive_window = 0;
+  // Streams announced in INIT/INIT-ACK, each stream is one data channel.
+  uint16_t sctp_max_inbound_streams = 0;
+  uint16_t sctp_max_outbound_streams = 0;
+  // Retransmission timeout bounds. A lower minimum recovers faster from
+  // loss on low latency links, a lower initial value speeds up setup.
+  uint32_t sctp_rto_initial_ms = 0;
+  uint32_t sctp_rto_min_ms = 0;
+  uint32_t sctp_rto_max_ms = 0;
+
+  // Target buffer duration in milliseconds of the PulseAudio capture and
+  // playout streams, 0 keeps the backend default. Smaller buffers lower the
+  // latency at the cost of more wakeups and underruns. libpulse reads it
+  // from PULSE_LATENCY_MSEC, which is only written before the threads of
+  // the first factory start, so later factories and a variable already set
+  // in the environment keep the value in effect. Other audio backends ignore
+  // it.
+  uint32_t audio_target_buffer_ms = 0;
+
+  // Threads of additional shards get the shard index appended to the name.
+  RTCThreadOptions network_thread;
+  RTCThreadOptions worker_thread;
+  RTCThreadOptions signaling_thread;
+  // Threads of capturers created through GetDesktopDevice().
+  RTCThreadOptions desktop_capture_thread;
+};
+
+enum class RTCPeerConnectionPoolRefill {
+  // Replace connections as soon as they are handed out or expire.
+  kImmediate,
+  // Only RefillPeerConnectionPool() tops the pool up, e.g. right before an
+  // expected burst of joins.
+  kManual,
+};
+
+// Peer connections built ahead of time, so that Create() skips
+// CreatePeerConnectionOrError(), candidate gathering and certificate
+// generation.
+struct RTCPeerConnectionPoolOptions {
+  // Idle connections kept ready, 0 disables the pool.
+  uint32_t size = 0;
+  // Idle connections older than this are closed and replaced since their
+  // candidates and TURN allocations go stale, 0 keeps them indefinitely.
+  uint32_t ttl_ms = 60000;
+  RTCPeerConnectionPoolRefill refill = RTCPeerConnectionPoolRefill::kImmediate;
+  // ECDSA DTLS certificates generated ahead of time for connections that do
+  // not come from the pool.
+  uint32_t certificates = 0;
+  // Create() and CreateAsync() only hand out a pooled connection when called
+  // with an equal configuration and equal constraints. Pooled connections
+  // pre-gather at least one candidate set even if ice_candidate_pool_size
+  // is 0.
+  RTCConfiguration configuration;
+  scoped_refptr<RTCMediaConstraints> constraints;
+};
+
+// UDP counters of the kernel over IPv4 and IPv6, to verify that socket
+// buffers are large enough. They cover the whole host, not only the sockets
+// of this library.
+struct RTCUdpDropCounters {
+  // False if the platform does not expose the counters. Linux and Android
+  // only.
+  bool available = false;
+  uint64_t in_datagrams = 0;
+  uint64_t out_datagrams = 0;
+  // Datagrams dropped because a receive buffer was full.
+  uint64_t receive_buffer_errors = 0;
+  // Datagrams dropped because a send buffer was full.
+  uint64_t send_buffer_errors = 0;
+  // Datagrams that could not be delivered, receive buffer drops included.
+  uint64_t in_errors = 0;
+};
+
+struct RTCPeerConnectionShardLoad {
+  uint32_t peerconnections = 0;
+  // Queueing delay of the latest probe task run on the network thread.
+  int64_t network_thread_delay_us = 0;
+};
+
 class RTCPeerConnectionFactory : public RefCountInterface {
  public:
+  typedef fixed_size_function<void(
+      scoped_refptr<RTCPeerConnection> peerconnection, RTCErrorType error,
+      const string message)>
+      OnPeerConnectionCreated;
+
   virtual bool Initialize() = 0;
 
   virtual bool Terminate() = 0;
@@ -30,8 +194,36 @@ class RTCPeerConnectionFactory : public RefCountInterface {
       const RTCConfiguration& configuration,
       scoped_refptr<RTCMediaConstraints> constraints) = 0;
 
+  // Builds the connection on the signaling thread and returns immediately.
+  // |callback| runs on the signaling thread with the connection, or with
+  // nullptr and the native error if creation failed.
+  virtual void CreateAsync(const RTCConfiguration& configuration,
+                           scoped_refptr<RTCMediaConstraints> constraints,
+                           OnPeerConnectionCreated callback) = 0;
+
   virtual void Delete(scoped_refptr<RTCPeerConnection> peerconnection) = 0;
 
+  // Replaces the pool settings, closes the idle connections built for the
+  // previous ones and starts filling the pool on the signaling thread.
+  virtual void ConfigurePeerConnectionPool(
+      const RTCPeerConnectionPoolOptions& options) = 0;
+
+  virtual void RefillPeerConnectionPool() = 0;
+
+  // Idle connections ready to be handed out.
+  virtual uint32_t pooled_peerconnections() = 0;
+
+  // One entry per thread group. Each call also posts a new probe task, so
+  // delays reflect the state as of the previous call.
+  virtual vector<RTCPeerConnectionShardLoad> GetShardLoad() = 0;
+
+  // Aggregated over all connections created with
+  // RTCConfiguration::trace_connection_setup.
+  virtual RTCSetupLatencyStats GetSetupLatencyStats(
+      RTCSetupMilestone milestone) = 0;
+
+  virtual RTCUdpDropCounters GetUdpDropCounters() = 0;
+
   virtual scoped_refptr<RTCAudioDevice> GetAudioDevice() = 0;
 
   virtual scoped_refptr<RTCAudioProcessing> GetAudioProcessing() = 0;
@@ -12,6 +12,14 @@ class RTCMediaTrack;
 class RTCDtlsTransport;
 class RTCDtmfSender;
 
+struct RTCRtpSenderBitrate {
+  // Applied to every encoding of the sender, -1 removes the limit.
+  int min_bitrate_bps = -1;
+  int max_bitrate_bps = -1;
+  // Share of the bandwidth estimate relative to the other senders.
+  double bitrate_priority = 1.0;
+};
+
 class RTCRtpSender : public RefCountInterface {
  public:
   virtual bool set_track(scoped_refptr<RTCMediaTrack> track) = 0;
@@ -39,6 +47,10 @@ class RTCRtpSender : public RefCountInterface {
       const scoped_refptr<RTCRtpParameters> parameters) = 0;
 
   virtual scoped_refptr<RTCDtmfSender> dtmf_sender() const = 0;
+
+  // Shortcut for parameters()/set_parameters() that only touches the
+  // bitrate fields. Takes effect without renegotiation.
+  virtual bool SetBitrate(const RTCRtpSenderBitrate& bitrate) = 0;
 };
 
 }  // namespace libwebrtc
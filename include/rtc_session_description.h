@@ -21,6 +21,9 @@ class RTCSessionDescription : public RefCountInterface {
 
   virtual bool ToString(string& out) = 0;
 
+  // Deep copy of the parsed description, no SDP parsing involved.
+  virtual scoped_refptr<RTCSessionDescription> Clone() = 0;
+
  protected:
   virtual ~RTCSessionDescription() {}
 };
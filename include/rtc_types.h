@@ -44,6 +44,16 @@ struct IceServer {
   string password;
 };
 
+inline bool operator==(const IceServer& a, const IceServer& b) {
+  return a.uri.std_string() == b.uri.std_string() &&
+         a.username.std_string() == b.username.std_string() &&
+         a.password.std_string() == b.password.std_string();
+}
+
+inline bool operator!=(const IceServer& a, const IceServer& b) {
+  return !(a == b);
+}
+
 enum class IceTransportsType { kNone, kRelay, kNoHost, kAll };
 
 enum class TcpCandidatePolicy {
@@ -69,6 +79,27 @@ enum BundlePolicy {
 
 enum class SdpSemantics { kPlanB, kUnifiedPlan };
 
+// Preset for ICE connection setup. kFastConnect pre-gathers a candidate pool,
+// checks candidate pairs more often while connectivity is weak, drops
+// unwritable pairs sooner, gathers continually and presumes TURN-only pairs
+// writable so media can flow before the first check response.
+enum class RTCIceProfile { kDefault, kFastConnect };
+
+// Bits of RTCConfiguration::network_ignore_mask, mirror webrtc::AdapterType.
+enum RTCAdapterType {
+  kAdapterTypeEthernet = 1 << 0,
+  kAdapterTypeWifi = 1 << 1,
+  kAdapterTypeCellular = 1 << 2,
+  kAdapterTypeVpn = 1 << 3,
+  kAdapterTypeLoopback = 1 << 4,
+};
+
+// Mirrors webrtc::Priority. With RTCConfiguration::enable_dscp, audio is
+// marked CS1, default, EF and EF from kVeryLow to kHigh, video CS1, default,
+// AF42 and AF41.
+enum class RTCNetworkPriority { kVeryLow, kLow, kMedium, kHigh };
+
+// New fields must also be compared in operator== below.
 struct RTCConfiguration {
   IceServer ice_servers[kMaxIceServerSize];
   IceTransportsType type = IceTransportsType::kAll;
@@ -80,6 +111,14 @@ struct RTCConfiguration {
       TcpCandidatePolicy::kTcpCandidatePolicyEnabled;
 
   int ice_candidate_pool_size = 0;
+  RTCIceProfile ice_profile = RTCIceProfile::kDefault;
+  // ICE timing in milliseconds. -1 keeps the value of |ice_profile|.
+  int ice_check_interval_weak_connectivity_ms = -1;
+  int ice_check_interval_strong_connectivity_ms = -1;
+  int ice_check_min_interval_ms = -1;
+  int ice_unwritable_timeout_ms = -1;
+  int ice_inactive_timeout_ms = -1;
+  int ice_connection_receiving_timeout_ms = -1;
 
   MediaSecurityType srtp_type = MediaSecurityType::kDTLS_SRTP;
   SdpSemantics sdp_semantics = SdpSemantics::kUnifiedPlan;
@@ -90,14 +129,178 @@ struct RTCConfiguration {
   bool disable_ipv6_on_wifi = false;
   int max_ipv6_networks = 5;
   bool disable_link_local_networks = false;
+  // RTCAdapterType bits, networks of these types are not used for ICE.
+  uint32_t network_ignore_mask = kAdapterTypeLoopback;
+  // Local port range for ICE sockets, 0 for both uses the range of the
+  // factory (RTCPeerConnectionFactoryOptions), or lets the OS choose.
+  uint16_t min_port = 0;
+  uint16_t max_port = 0;
   int screencast_min_bitrate = -1;
 
+  // Media settings that used to need RTCMediaConstraints. Constraints passed
+  // to RTCPeerConnectionFactory::Create() still take precedence.
+  // Marks outgoing packets with DSCP code points.
+  bool enable_dscp = false;
+  // Lets the video encoder scale down when the CPU is overused.
+  bool cpu_overuse_detection = true;
+  // Stops sending video when the estimate drops below the minimum bitrate.
+  bool suspend_below_min_bitrate = false;
+  // Runs one bandwidth estimate over audio and video.
+  bool combined_audio_video_bwe = false;
+  // DSCP marking per media type when |enable_dscp| is set. Applied to the
+  // senders created by AddTrack() and AddTransceiver().
+  RTCNetworkPriority audio_network_priority = RTCNetworkPriority::kLow;
+  RTCNetworkPriority video_network_priority = RTCNetworkPriority::kLow;
+
+  // Largest data channel message accepted from the remote peer, advertised
+  // through a=max-message-size in created offers and answers. 0 keeps the
+  // native default (256 KiB). Values above the SCTP receive window, 5 MiB
+  // unless RTCPeerConnectionFactoryOptions::sctp_receive_window is set, are
+  // clamped to it. Only the advertisement changes: the remote
+  // peer honours it when sending, the local SCTP transport keeps its own
+  // limits.
+  uint32_t sctp_max_message_size = 0;
+
+  // Coalesces local ICE candidates into
+  // RTCPeerConnectionObserver::OnIceCandidates() batches. 0 delivers every
+  // candidate on its own, a positive value collects candidates for that many
+  // milliseconds, -1 holds them until gathering completes. Pending
+  // candidates are always flushed when gathering completes. Continual
+  // gathering, as used by RTCIceProfile::kFastConnect, never completes, so
+  // -1 is replaced by a 100 ms window there.
+  int ice_candidate_batch_window_ms = 0;
+
+  // Records RTCSetupMilestone timestamps, see
+  // RTCPeerConnection::setup_timeline().
+  bool trace_connection_setup = false;
+
+  // Lets the factory place the connection on one of the additional thread
+  // groups of RTCPeerConnectionFactoryOptions::network_shards. Those groups
+  // have no audio device or audio processing and their own worker thread,
+  // so the connection must only carry data channels: tracks from the
+  // factory's sources belong to the first group and must not be added to
+  // it. Other connections always stay on the first group.
+  bool use_network_shard = false;
+
   // private
   bool use_rtp_mux = true;
+  // Unused.
   uint32_t local_audio_bandwidth = 128;
+  // Written as kbps into the video section of remote descriptions, capping
+  // what is sent. 0 disables the rewrite; prefer
+  // RTCPeerConnection::SetBitrate() and RTCRtpSender::SetBitrate().
   uint32_t local_video_bandwidth = 512;
 };
 
+// Field by field, used to match connections against the pool configuration
+// (RTCPeerConnectionPoolOptions).
+inline bool operator==(const RTCConfiguration& a, const RTCConfiguration& b) {
+  for (int i = 0; i < kMaxIceServerSize; i++) {
+    if (a.ice_servers[i] != b.ice_servers[i]) return false;
+  }
+  return a.type == b.type && a.bundle_policy == b.bundle_policy &&
+         a.rtcp_mux_policy == b.rtcp_mux_policy &&
+         a.candidate_network_policy == b.candidate_network_policy &&
+         a.tcp_candidate_policy == b.tcp_candidate_policy &&
+         a.ice_candidate_pool_size == b.ice_candidate_pool_size &&
+         a.ice_profile == b.ice_profile &&
+         a.ice_check_interval_weak_connectivity_ms ==
+             b.ice_check_interval_weak_connectivity_ms &&
+         a.ice_check_interval_strong_connectivity_ms ==
+             b.ice_check_interval_strong_connectivity_ms &&
+         a.ice_check_min_interval_ms == b.ice_check_min_interval_ms &&
+         a.ice_unwritable_timeout_ms == b.ice_unwritable_timeout_ms &&
+         a.ice_inactive_timeout_ms == b.ice_inactive_timeout_ms &&
+         a.ice_connection_receiving_timeout_ms ==
+             b.ice_connection_receiving_timeout_ms &&
+         a.srtp_type == b.srtp_type && a.sdp_semantics == b.sdp_semantics &&
+         a.offer_to_receive_audio == b.offer_to_receive_audio &&
+         a.offer_to_receive_video == b.offer_to_receive_video &&
+         a.disable_ipv6 == b.disable_ipv6 &&
+         a.disable_ipv6_on_wifi == b.disable_ipv6_on_wifi &&
+         a.max_ipv6_networks == b.max_ipv6_networks &&
+         a.disable_link_local_networks == b.disable_link_local_networks &&
+         a.network_ignore_mask == b.network_ignore_mask &&
+         a.min_port == b.min_port && a.max_port == b.max_port &&
+         a.screencast_min_bitrate == b.screencast_min_bitrate &&
+         a.enable_dscp == b.enable_dscp &&
+         a.cpu_overuse_detection == b.cpu_overuse_detection &&
+         a.suspend_below_min_bitrate == b.suspend_below_min_bitrate &&
+         a.combined_audio_video_bwe == b.combined_audio_video_bwe &&
+         a.audio_network_priority == b.audio_network_priority &&
+         a.video_network_priority == b.video_network_priority &&
+         a.sctp_max_message_size == b.sctp_max_message_size &&
+         a.ice_candidate_batch_window_ms == b.ice_candidate_batch_window_ms &&
+         a.trace_connection_setup == b.trace_connection_setup &&
+         a.use_network_shard == b.use_network_shard &&
+         a.use_rtp_mux == b.use_rtp_mux &&
+         a.local_audio_bandwidth == b.local_audio_bandwidth &&
+         a.local_video_bandwidth == b.local_video_bandwidth;
+}
+
+inline bool operator!=(const RTCConfiguration& a, const RTCConfiguration& b) {
+  return !(a == b);
+}
+
+// Mirrors webrtc::RTCErrorType.
+enum class RTCErrorType {
+  kNone,
+  kUnsupportedOperation,
+  kUnsupportedParameter,
+  kInvalidParameter,
+  kInvalidRange,
+  kSyntaxError,
+  kInvalidState,
+  kInvalidModification,
+  kNetworkError,
+  kResourceExhausted,
+  kInternalError,
+  kOperationErrorWithData,
+};
+
+// Milestones of connection setup, recorded when
+// RTCConfiguration::trace_connection_setup is set. The media milestones are
+// taken from periodic stats probes once DTLS is connected and have a
+// resolution of about 100 ms.
+enum class RTCSetupMilestone {
+  kCreateOfferComplete,
+  kCreateAnswerComplete,
+  kSetLocalDescriptionComplete,
+  kSetRemoteDescriptionComplete,
+  kFirstLocalCandidate,
+  kIceChecking,
+  kIceConnected,
+  kDtlsConnected,
+  kFirstRtpSent,
+  kFirstRtpReceived,
+  kFirstFrameDecoded,
+  kCount,
+};
+
+enum { kSetupMilestoneCount = static_cast<int>(RTCSetupMilestone::kCount) };
+
+// Microseconds from the creation of a connection, or from the moment it was
+// handed out of the warm pool, to the first occurrence of each milestone.
+// -1 if the milestone has not been reached.
+struct RTCSetupTimeline {
+  RTCSetupTimeline() {
+    for (int i = 0; i < kSetupMilestoneCount; i++) milestone_us[i] = -1;
+  }
+
+  int64_t milestone_us[kSetupMilestoneCount];
+};
+
+// Latency of one milestone across traced connections.
+struct RTCSetupLatencyStats {
+  // Connections that reached the milestone. Percentiles cover the most
+  // recent 1024 of them.
+  uint64_t samples = 0;
+  int64_t p50_us = 0;
+  int64_t p90_us = 0;
+  int64_t p99_us = 0;
+  int64_t max_us = 0;
+};
+
 struct SdpParseError {
  public:
   // The sdp line that causes the error.
@@ -17,6 +17,10 @@ class RTCVideoCapturer : public RefCountInterface {
 };
 
 class RTCVideoDevice : public RefCountInterface {
+ public:
+  typedef fixed_size_function<void(scoped_refptr<RTCVideoCapturer> capturer)>
+      OnCapturerCreated;
+
  public:
   virtual uint32_t NumberOfDevices() = 0;
 
@@ -32,6 +36,13 @@ class RTCVideoDevice : public RefCountInterface {
                                                  size_t height,
                                                  size_t target_fps) = 0;
 
+  // Non-blocking variant of Create(), the capturer is opened on the worker
+  // thread and |callback| is invoked there with the result (nullptr on
+  // failure).
+  virtual void CreateAsync(const char* name, uint32_t index, size_t width,
+                           size_t height, size_t target_fps,
+                           OnCapturerCreated callback) = 0;
+
  protected:
   virtual ~RTCVideoDevice() {}
 };
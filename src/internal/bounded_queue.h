@@ -0,0 +1,72 @@
+#ifndef INTERNAL_BOUNDED_QUEUE_H_
+#define INTERNAL_BOUNDED_QUEUE_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace libwebrtc {
+
+// Bounded lock-free ring buffer for exactly one producer thread and one
+// consumer thread. Push() fails instead of blocking when the ring is full, so
+// the producer decides what to do on overflow.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1), slots_(capacity_ + 1) {}
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Producer side. Leaves |value| untouched when the queue is full.
+  bool Push(T&& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t next = Next(tail);
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots_[tail] = std::move(value);
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool Pop(T* value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *value = std::move(slots_[head]);
+    slots_[head] = T();
+    head_.store(Next(head), std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with Push()/Pop().
+  size_t size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + slots_.size() - head;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  size_t Next(size_t index) const {
+    return index + 1 == slots_.size() ? 0 : index + 1;
+  }
+
+  const size_t capacity_;
+  std::vector<T> slots_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_BOUNDED_QUEUE_H_
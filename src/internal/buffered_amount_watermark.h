@@ -0,0 +1,47 @@
+#ifndef INTERNAL_BUFFERED_AMOUNT_WATERMARK_H_
+#define INTERNAL_BUFFERED_AMOUNT_WATERMARK_H_
+
+#include <stdint.h>
+
+namespace libwebrtc {
+
+// Decides when the buffered amount of a data channel crossed its low
+// threshold. Compares against the last amount seen as well as the size of
+// the latest drain, so drops spread over several callbacks and a single
+// send that crossed the threshold on its own are both caught. Not thread
+// safe, callers serialize access.
+class BufferedAmountWatermark {
+ public:
+  // Records the buffered amount after |drained| bytes left the buffer.
+  // Returns true when it went from above the threshold to at or below it.
+  // Sends raise the amount without a callback, so the amount before the
+  // change is at least |amount| + |drained| even if the last one seen was
+  // lower.
+  bool Update(uint64_t amount, uint64_t drained = 0) {
+    uint64_t previous = amount_;
+    if (amount + drained > previous) previous = amount + drained;
+    amount_ = amount;
+    return previous > threshold_ && amount <= threshold_;
+  }
+
+  // Returns true when the last amount seen was above the old threshold and
+  // is at or below the new one, so a sender waiting for the event is not
+  // left hanging.
+  bool SetThreshold(uint64_t threshold) {
+    uint64_t previous = threshold_;
+    threshold_ = threshold;
+    return amount_ > previous && amount_ <= threshold;
+  }
+
+  uint64_t amount() const { return amount_; }
+
+  uint64_t threshold() const { return threshold_; }
+
+ private:
+  uint64_t amount_ = 0;
+  uint64_t threshold_ = 0;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_BUFFERED_AMOUNT_WATERMARK_H_
@@ -0,0 +1,25 @@
+#ifndef INTERNAL_CONSTRAINT_LIST_H_
+#define INTERNAL_CONSTRAINT_LIST_H_
+
+#include <stddef.h>
+
+namespace libwebrtc {
+
+// Compares two lists of key/value constraints in order. A null list is the
+// same as an empty one, so a connection created without constraints matches
+// a pool filled with an empty RTCMediaConstraints.
+template <typename Constraints>
+bool SameConstraintList(const Constraints* a, const Constraints* b) {
+  size_t size_a = a ? a->size() : 0;
+  size_t size_b = b ? b->size() : 0;
+  if (size_a != size_b) return false;
+  for (size_t i = 0; i < size_a; i++) {
+    if ((*a)[i].key != (*b)[i].key || (*a)[i].value != (*b)[i].value)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_CONSTRAINT_LIST_H_
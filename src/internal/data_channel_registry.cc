@@ -0,0 +1,198 @@
+#include "src/internal/data_channel_registry.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace libwebrtc {
+
+namespace {
+
+void Accumulate(RTCDataChannelTrafficStats& total,
+                const RTCDataChannelTrafficStats& stats) {
+  total.messages_sent += stats.messages_sent;
+  total.bytes_sent += stats.bytes_sent;
+  total.messages_received += stats.messages_received;
+  total.bytes_received += stats.bytes_received;
+}
+
+}  // namespace
+
+DataChannelRegistry::DataChannelRegistry()
+    : has_closed_(std::make_shared<std::atomic<bool>>(false)) {}
+
+void DataChannelRegistry::Add(scoped_refptr<RTCDataChannel> channel) {
+  if (!channel) return;
+  PruneClosed();
+  int id = channel->id();
+  std::string label = channel->label().std_string();
+  webrtc::MutexLock lock(&mutex_);
+  Entry& entry = channels_[channel.get()];
+  if (entry.channel) return;
+  entry.channel = channel;
+  entry.label = label;
+  entry.id = id;
+  by_label_[label].push_back(channel.get());
+  if (id >= 0) {
+    // A closed channel's stream id may be reused by a new one.
+    by_id_[id] = channel.get();
+  } else {
+    pending_.push_back(channel);
+  }
+}
+
+std::function<void()> DataChannelRegistry::CloseNotifier() const {
+  std::weak_ptr<std::atomic<bool>> has_closed = has_closed_;
+  return [has_closed] {
+    if (auto flag = has_closed.lock()) *flag = true;
+  };
+}
+
+scoped_refptr<RTCDataChannel> DataChannelRegistry::FindById(int id) {
+  PruneClosed();
+  {
+    webrtc::MutexLock lock(&mutex_);
+    auto it = by_id_.find(id);
+    if (it != by_id_.end()) return channels_[it->second].channel;
+    if (pending_.empty()) return nullptr;
+  }
+  IndexPending();
+  webrtc::MutexLock lock(&mutex_);
+  auto it = by_id_.find(id);
+  if (it == by_id_.end()) return nullptr;
+  return channels_[it->second].channel;
+}
+
+scoped_refptr<RTCDataChannel> DataChannelRegistry::FindByLabel(
+    const std::string& label) {
+  PruneClosed();
+  webrtc::MutexLock lock(&mutex_);
+  auto it = by_label_.find(label);
+  if (it == by_label_.end()) return nullptr;
+  return channels_[it->second.back()].channel;
+}
+
+std::vector<scoped_refptr<RTCDataChannel>> DataChannelRegistry::List() {
+  PruneClosed();
+  webrtc::MutexLock lock(&mutex_);
+  std::vector<scoped_refptr<RTCDataChannel>> channels;
+  channels.reserve(channels_.size());
+  for (auto& it : channels_) channels.push_back(it.second.channel);
+  return channels;
+}
+
+void DataChannelRegistry::CloseAll() {
+  // Close() hops to the signaling thread, don't hold the lock meanwhile.
+  for (auto& channel : List()) channel->Close();
+}
+
+RTCDataChannelTrafficStats DataChannelRegistry::TrafficStats() {
+  PruneClosed();
+  RTCDataChannelTrafficStats total;
+  for (auto& channel : Snapshot(&total))
+    Accumulate(total, channel->traffic_stats());
+  return total;
+}
+
+void DataChannelRegistry::Clear() {
+  std::vector<scoped_refptr<RTCDataChannel>> channels;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    for (auto& it : channels_) channels.push_back(it.second.channel);
+    retiring_.insert(retiring_.end(), channels.begin(), channels.end());
+    channels_.clear();
+    by_id_.clear();
+    by_label_.clear();
+    pending_.clear();
+  }
+  Retire(channels);
+}
+
+void DataChannelRegistry::PruneClosed() {
+  if (!has_closed_->exchange(false)) return;
+  IndexPending();
+  std::vector<scoped_refptr<RTCDataChannel>> closed;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    // state() is cached by the channel and does not block.
+    for (auto& it : channels_) {
+      if (it.second.channel->state() == RTCDataChannelClosed)
+        closed.push_back(it.second.channel);
+    }
+    for (auto& channel : closed) Remove_l(channel.get());
+    retiring_.insert(retiring_.end(), closed.begin(), closed.end());
+  }
+  Retire(closed);
+}
+
+std::vector<scoped_refptr<RTCDataChannel>> DataChannelRegistry::Snapshot(
+    RTCDataChannelTrafficStats* retired) {
+  webrtc::MutexLock lock(&mutex_);
+  *retired = retired_;
+  std::vector<scoped_refptr<RTCDataChannel>> channels;
+  channels.reserve(channels_.size() + retiring_.size());
+  for (auto& it : channels_) channels.push_back(it.second.channel);
+  channels.insert(channels.end(), retiring_.begin(), retiring_.end());
+  return channels;
+}
+
+void DataChannelRegistry::Retire(
+    const std::vector<scoped_refptr<RTCDataChannel>>& channels) {
+  if (channels.empty()) return;
+  RTCDataChannelTrafficStats stats;
+  for (auto& channel : channels) Accumulate(stats, channel->traffic_stats());
+  webrtc::MutexLock lock(&mutex_);
+  Accumulate(retired_, stats);
+  for (auto& channel : channels) {
+    retiring_.erase(std::remove(retiring_.begin(), retiring_.end(), channel),
+                    retiring_.end());
+  }
+}
+
+void DataChannelRegistry::IndexPending() {
+  std::vector<scoped_refptr<RTCDataChannel>> pending;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    pending = pending_;
+  }
+  std::vector<std::pair<int, scoped_refptr<RTCDataChannel>>> assigned;
+  for (auto& channel : pending) {
+    int id = channel->id();
+    if (id >= 0) assigned.emplace_back(id, channel);
+  }
+  if (assigned.empty()) return;
+  webrtc::MutexLock lock(&mutex_);
+  for (auto& it : assigned) {
+    auto pos = std::find(pending_.begin(), pending_.end(), it.second);
+    // Pruned or cleared meanwhile.
+    if (pos == pending_.end()) continue;
+    pending_.erase(pos);
+    channels_[it.second.get()].id = it.first;
+    by_id_[it.first] = it.second.get();
+  }
+}
+
+void DataChannelRegistry::Remove_l(RTCDataChannel* channel) {
+  auto entry = channels_.find(channel);
+  if (entry == channels_.end()) return;
+  const Entry& removed = entry->second;
+  if (removed.id >= 0) {
+    auto by_id = by_id_.find(removed.id);
+    // The id may have been taken over by a newer channel.
+    if (by_id != by_id_.end() && by_id->second == channel) by_id_.erase(by_id);
+  } else {
+    pending_.erase(
+        std::remove(pending_.begin(), pending_.end(), removed.channel),
+        pending_.end());
+  }
+  auto by_label = by_label_.find(removed.label);
+  if (by_label != by_label_.end()) {
+    std::vector<RTCDataChannel*>& same_label = by_label->second;
+    same_label.erase(
+        std::remove(same_label.begin(), same_label.end(), channel),
+        same_label.end());
+    if (same_label.empty()) by_label_.erase(by_label);
+  }
+  channels_.erase(entry);
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,91 @@
+#ifndef INTERNAL_DATA_CHANNEL_REGISTRY_H_
+#define INTERNAL_DATA_CHANNEL_REGISTRY_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_data_channel.h"
+
+namespace libwebrtc {
+
+// Owns the data channels of a peer connection and indexes them by SCTP stream
+// id and by label. Channels created before the SCTP transport is up have no
+// stream id yet; they are kept aside and indexed once their id is assigned.
+// Channels report their closing through CloseNotifier(); closed channels are
+// then dropped on the next call and their counters folded into the aggregate
+// traffic stats. id() and traffic_stats() are proxied to the network thread,
+// so they are never called with |mutex_| held.
+class DataChannelRegistry {
+ public:
+  DataChannelRegistry();
+
+  void Add(scoped_refptr<RTCDataChannel> channel);
+
+  // Returns a callback for a channel to run once it is closed. It may outlive
+  // the registry and be run from any thread.
+  std::function<void()> CloseNotifier() const;
+
+  scoped_refptr<RTCDataChannel> FindById(int id);
+
+  // Labels are not unique, returns the most recently added open match. Once
+  // it closes, the one added before it is returned again.
+  scoped_refptr<RTCDataChannel> FindByLabel(const std::string& label);
+
+  std::vector<scoped_refptr<RTCDataChannel>> List();
+
+  void CloseAll();
+
+  RTCDataChannelTrafficStats TrafficStats();
+
+  // Drops all channels, keeping their counters in the aggregate.
+  void Clear();
+
+ private:
+  // Drops the closed channels once one has reported closing, and folds
+  // their counters into |retired_|.
+  void PruneClosed();
+
+  // Returns every channel, including those being retired, and the counters
+  // of the channels already retired.
+  std::vector<scoped_refptr<RTCDataChannel>> Snapshot(
+      RTCDataChannelTrafficStats* retired);
+
+  // Indexes the pending channels whose stream id has been assigned.
+  void IndexPending();
+
+  void Remove_l(RTCDataChannel* channel);
+
+  // Moves |channels| from |retiring_| into |retired_| with their counters.
+  void Retire(const std::vector<scoped_refptr<RTCDataChannel>>& channels);
+
+  std::shared_ptr<std::atomic<bool>> has_closed_;
+
+  struct Entry {
+    scoped_refptr<RTCDataChannel> channel;
+    std::string label;
+    // -1 while the channel is pending.
+    int id = -1;
+  };
+
+  // The _l helpers expect |mutex_| to be held.
+  webrtc::Mutex mutex_;
+  // Every indexed channel, keyed by itself, so removal needs no scan.
+  std::unordered_map<RTCDataChannel*, Entry> channels_;
+  std::unordered_map<int, RTCDataChannel*> by_id_;
+  // Oldest first.
+  std::unordered_map<std::string, std::vector<RTCDataChannel*>> by_label_;
+  std::vector<scoped_refptr<RTCDataChannel>> pending_;
+  // Channels dropped from the indexes whose counters are not folded into
+  // |retired_| yet.
+  std::vector<scoped_refptr<RTCDataChannel>> retiring_;
+  RTCDataChannelTrafficStats retired_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_DATA_CHANNEL_REGISTRY_H_
@@ -0,0 +1,84 @@
+#ifndef INTERNAL_DATA_TRANSFER_FRAMING_H_
+#define INTERNAL_DATA_TRANSFER_FRAMING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace libwebrtc {
+
+// Wire format of RTCDataTransfer, all integers little endian:
+//   kBegin  : kind u8 | id u32 | size u64 | name
+//   kChunk  : kind u8 | id u32 | offset u64 | payload
+//   kEnd    : kind u8 | id u32
+//   kAbort  : kind u8 | id u32   (sender gave up on its transfer)
+//   kReject : kind u8 | id u32   (receiver refused or cancelled it)
+// Ids on the wire are the sender's ids and never have
+// kIncomingTransferIdBit set.
+enum TransferFrameKind : uint8_t {
+  kTransferBegin = 1,
+  kTransferChunk = 2,
+  kTransferEnd = 3,
+  kTransferAbort = 4,
+  kTransferReject = 5,
+};
+
+const size_t kTransferControlHeaderSize = 5;
+const size_t kTransferChunkHeaderSize = kTransferControlHeaderSize + 8;
+
+struct TransferFrame {
+  uint8_t kind = 0;
+  uint32_t id = 0;
+  // Total size for kTransferBegin, offset for kTransferChunk.
+  uint64_t value = 0;
+  // Name for kTransferBegin, data for kTransferChunk.
+  const uint8_t* payload = nullptr;
+  size_t payload_size = 0;
+};
+
+inline void WriteTransferUint32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline void WriteTransferUint64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline uint32_t ReadTransferUint32(const uint8_t* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  return value;
+}
+
+inline uint64_t ReadTransferUint64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  return value;
+}
+
+// Splits a message into its fields. Returns false if the message is too
+// short for its kind. Unknown kinds are returned with only |id| set.
+inline bool ParseTransferFrame(const uint8_t* data, size_t size,
+                               TransferFrame* frame) {
+  if (size < kTransferControlHeaderSize) return false;
+  frame->kind = data[0];
+  frame->id = ReadTransferUint32(data + 1);
+  frame->value = 0;
+  frame->payload = nullptr;
+  frame->payload_size = 0;
+  if (frame->kind != kTransferBegin && frame->kind != kTransferChunk)
+    return true;
+  if (size < kTransferChunkHeaderSize) return false;
+  frame->value = ReadTransferUint64(data + kTransferControlHeaderSize);
+  frame->payload = data + kTransferChunkHeaderSize;
+  frame->payload_size = size - kTransferChunkHeaderSize;
+  return true;
+}
+
+// True if |size| bytes at |offset| lie within a transfer of |total| bytes.
+inline bool TransferChunkFits(uint64_t offset, uint64_t size, uint64_t total) {
+  return size <= total && offset <= total - size;
+}
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_DATA_TRANSFER_FRAMING_H_
@@ -0,0 +1,62 @@
+#ifndef INTERNAL_LATENCY_WINDOW_H_
+#define INTERNAL_LATENCY_WINDOW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+// Keeps the most recent |capacity| latencies of a milestone and derives
+// nearest-rank percentiles from them. Not thread safe, callers serialize
+// access.
+class LatencyWindow {
+ public:
+  explicit LatencyWindow(size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1) {}
+
+  // Overwrites the oldest sample once the window is full.
+  void Add(int64_t latency_us) {
+    if (values_.size() < capacity_) {
+      values_.push_back(latency_us);
+    } else {
+      values_[next_] = latency_us;
+    }
+    next_ = (next_ + 1) % capacity_;
+    count_++;
+  }
+
+  // |samples| counts every sample added, the rest covers the window only.
+  RTCSetupLatencyStats Stats() const {
+    RTCSetupLatencyStats stats;
+    stats.samples = count_;
+    if (values_.empty()) return stats;
+
+    std::vector<int64_t> sorted = values_;
+    std::sort(sorted.begin(), sorted.end());
+    // Smallest value with at least p percent of the samples at or below it.
+    auto percentile = [&sorted](size_t p) {
+      size_t rank = (sorted.size() * p + 99) / 100;
+      return sorted[rank > 0 ? rank - 1 : 0];
+    };
+    stats.p50_us = percentile(50);
+    stats.p90_us = percentile(90);
+    stats.p99_us = percentile(99);
+    stats.max_us = sorted.back();
+    return stats;
+  }
+
+ private:
+  size_t capacity_;
+  std::vector<int64_t> values_;
+  size_t next_ = 0;
+  uint64_t count_ = 0;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_LATENCY_WINDOW_H_
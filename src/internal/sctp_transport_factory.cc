@@ -0,0 +1,80 @@
+#include "src/internal/sctp_transport_factory.h"
+
+#include <utility>
+
+#include "media/sctp/dcsctp_transport.h"
+#include "net/dcsctp/public/dcsctp_socket_factory.h"
+#include "net/dcsctp/public/types.h"
+
+namespace libwebrtc {
+
+namespace {
+
+// The transport fills in ports, message size and its own limits before it
+// creates the socket, the tuning is layered on top of those.
+class TunedSocketFactory : public dcsctp::DcSctpSocketFactory {
+ public:
+  explicit TunedSocketFactory(const RTCPeerConnectionFactoryOptions& options)
+      : options_(options) {}
+
+  std::unique_ptr<dcsctp::DcSctpSocketInterface> Create(
+      absl::string_view log_prefix, dcsctp::DcSctpSocketCallbacks& callbacks,
+      std::unique_ptr<dcsctp::PacketObserver> packet_observer,
+      const dcsctp::DcSctpOptions& options) override {
+    dcsctp::DcSctpOptions tuned = options;
+    if (options_.sctp_send_queue_limit > 0)
+      tuned.per_stream_send_queue_limit = options_.sctp_send_queue_limit;
+    if (options_.sctp_receive_window > 0)
+      tuned.max_receiver_window_buffer_size = options_.sctp_receive_window;
+    if (options_.sctp_max_inbound_streams > 0) {
+      tuned.announced_maximum_incoming_streams =
+          options_.sctp_max_inbound_streams;
+    }
+    if (options_.sctp_max_outbound_streams > 0) {
+      tuned.announced_maximum_outgoing_streams =
+          options_.sctp_max_outbound_streams;
+    }
+    if (options_.sctp_rto_initial_ms > 0) {
+      tuned.rto_initial =
+          dcsctp::DurationMs(static_cast<int32_t>(options_.sctp_rto_initial_ms));
+    }
+    if (options_.sctp_rto_min_ms > 0) {
+      tuned.rto_min =
+          dcsctp::DurationMs(static_cast<int32_t>(options_.sctp_rto_min_ms));
+    }
+    if (options_.sctp_rto_max_ms > 0) {
+      tuned.rto_max =
+          dcsctp::DurationMs(static_cast<int32_t>(options_.sctp_rto_max_ms));
+    }
+    return dcsctp::DcSctpSocketFactory::Create(
+        log_prefix, callbacks, std::move(packet_observer), tuned);
+  }
+
+ private:
+  RTCPeerConnectionFactoryOptions options_;
+};
+
+}  // namespace
+
+bool HasSctpTuning(const RTCPeerConnectionFactoryOptions& options) {
+  return options.sctp_send_queue_limit > 0 || options.sctp_receive_window > 0 ||
+         options.sctp_max_inbound_streams > 0 ||
+         options.sctp_max_outbound_streams > 0 ||
+         options.sctp_rto_initial_ms > 0 || options.sctp_rto_min_ms > 0 ||
+         options.sctp_rto_max_ms > 0;
+}
+
+TunedSctpTransportFactory::TunedSctpTransportFactory(
+    webrtc::Thread* network_thread,
+    const RTCPeerConnectionFactoryOptions& options)
+    : network_thread_(network_thread), options_(options) {}
+
+std::unique_ptr<webrtc::SctpTransportInternal>
+TunedSctpTransportFactory::CreateSctpTransport(
+    const webrtc::Environment& env, webrtc::DtlsTransportInternal* transport) {
+  return std::make_unique<webrtc::DcSctpTransport>(
+      env, network_thread_, transport,
+      std::make_unique<TunedSocketFactory>(options_));
+}
+
+}  // namespace libwebrtc
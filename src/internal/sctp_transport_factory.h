@@ -0,0 +1,34 @@
+#ifndef INTERNAL_SCTP_TRANSPORT_FACTORY_H_
+#define INTERNAL_SCTP_TRANSPORT_FACTORY_H_
+
+#include <memory>
+
+#include "api/environment/environment.h"
+#include "api/transport/sctp_transport_factory_interface.h"
+#include "rtc_base/thread.h"
+#include "rtc_peerconnection_factory.h"
+
+namespace libwebrtc {
+
+// True if any of the SCTP options differs from the native default.
+bool HasSctpTuning(const RTCPeerConnectionFactoryOptions& options);
+
+// Creates dcSCTP transports with the SCTP options of |options| applied on
+// top of the ones the native transport derives from the session.
+class TunedSctpTransportFactory : public webrtc::SctpTransportFactoryInterface {
+ public:
+  TunedSctpTransportFactory(webrtc::Thread* network_thread,
+                            const RTCPeerConnectionFactoryOptions& options);
+
+  std::unique_ptr<webrtc::SctpTransportInternal> CreateSctpTransport(
+      const webrtc::Environment& env,
+      webrtc::DtlsTransportInternal* transport) override;
+
+ private:
+  webrtc::Thread* network_thread_;
+  RTCPeerConnectionFactoryOptions options_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_SCTP_TRANSPORT_FACTORY_H_
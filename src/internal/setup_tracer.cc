@@ -0,0 +1,74 @@
+#include "src/internal/setup_tracer.h"
+
+#include "api/stats/rtcstats_objects.h"
+#include "rtc_base/time_utils.h"
+
+namespace libwebrtc {
+
+SetupLatencyAggregator::SetupLatencyAggregator()
+    : samples_(kSetupMilestoneCount, LatencyWindow(kWindow)) {}
+
+void SetupLatencyAggregator::Add(RTCSetupMilestone milestone,
+                                 int64_t latency_us) {
+  webrtc::MutexLock lock(&mutex_);
+  samples_[static_cast<int>(milestone)].Add(latency_us);
+}
+
+RTCSetupLatencyStats SetupLatencyAggregator::Stats(
+    RTCSetupMilestone milestone) const {
+  // Sorts a copy of at most kWindow samples, cheap enough to do under the
+  // lock.
+  webrtc::MutexLock lock(&mutex_);
+  return samples_[static_cast<int>(milestone)].Stats();
+}
+
+SetupTracer::SetupTracer() : origin_us_(webrtc::TimeMicros()) {
+  for (int i = 0; i < kSetupMilestoneCount; i++) milestone_us_[i] = -1;
+}
+
+void SetupTracer::Restart() {
+  origin_us_ = webrtc::TimeMicros();
+  for (int i = 0; i < kSetupMilestoneCount; i++) milestone_us_[i] = -1;
+}
+
+void SetupTracer::Mark(RTCSetupMilestone milestone) {
+  int64_t elapsed_us = Elapsed();
+  int64_t expected = -1;
+  if (!milestone_us_[static_cast<int>(milestone)].compare_exchange_strong(
+          expected, elapsed_us))
+    return;
+  if (aggregator_) aggregator_->Add(milestone, elapsed_us);
+}
+
+bool SetupTracer::Reached(RTCSetupMilestone milestone) const {
+  return milestone_us_[static_cast<int>(milestone)] >= 0;
+}
+
+int64_t SetupTracer::Elapsed() const {
+  return webrtc::TimeMicros() - origin_us_;
+}
+
+RTCSetupTimeline SetupTracer::timeline() const {
+  RTCSetupTimeline timeline;
+  for (int i = 0; i < kSetupMilestoneCount; i++)
+    timeline.milestone_us[i] = milestone_us_[i];
+  return timeline;
+}
+
+void SetupStatsProbe::OnStatsDelivered(
+    const webrtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
+  for (const webrtc::RTCOutboundRtpStreamStats* stats :
+       report->GetStatsOfType<webrtc::RTCOutboundRtpStreamStats>()) {
+    if (stats->packets_sent.value_or(0) > 0)
+      tracer_->Mark(RTCSetupMilestone::kFirstRtpSent);
+  }
+  for (const webrtc::RTCInboundRtpStreamStats* stats :
+       report->GetStatsOfType<webrtc::RTCInboundRtpStreamStats>()) {
+    if (stats->packets_received.value_or(0) > 0)
+      tracer_->Mark(RTCSetupMilestone::kFirstRtpReceived);
+    if (stats->frames_decoded.value_or(0) > 0)
+      tracer_->Mark(RTCSetupMilestone::kFirstFrameDecoded);
+  }
+}
+
+}  // namespace libwebrtc
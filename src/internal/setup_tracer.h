@@ -0,0 +1,77 @@
+#ifndef INTERNAL_SETUP_TRACER_H_
+#define INTERNAL_SETUP_TRACER_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "api/stats/rtc_stats_collector_callback.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_types.h"
+#include "src/internal/latency_window.h"
+
+namespace libwebrtc {
+
+// Collects the latency of every milestone across connections and keeps the
+// most recent samples for percentiles. Shared by the connections of a
+// factory.
+class SetupLatencyAggregator {
+ public:
+  SetupLatencyAggregator();
+
+  void Add(RTCSetupMilestone milestone, int64_t latency_us);
+
+  RTCSetupLatencyStats Stats(RTCSetupMilestone milestone) const;
+
+ private:
+  static constexpr size_t kWindow = 1024;
+
+  mutable webrtc::Mutex mutex_;
+  std::vector<LatencyWindow> samples_;
+};
+
+// Timeline of one connection. Only the first occurrence of a milestone is
+// recorded; Mark() may be called from any thread.
+class SetupTracer {
+ public:
+  SetupTracer();
+
+  void set_aggregator(std::shared_ptr<SetupLatencyAggregator> aggregator) {
+    aggregator_ = aggregator;
+  }
+
+  // Moves the origin to now and forgets all milestones.
+  void Restart();
+
+  void Mark(RTCSetupMilestone milestone);
+
+  bool Reached(RTCSetupMilestone milestone) const;
+
+  // Microseconds since the origin.
+  int64_t Elapsed() const;
+
+  RTCSetupTimeline timeline() const;
+
+ private:
+  std::atomic<int64_t> origin_us_;
+  std::atomic<int64_t> milestone_us_[kSetupMilestoneCount];
+  std::shared_ptr<SetupLatencyAggregator> aggregator_;
+};
+
+// Marks the media milestones from a stats report.
+class SetupStatsProbe : public webrtc::RTCStatsCollectorCallback {
+ public:
+  explicit SetupStatsProbe(std::shared_ptr<SetupTracer> tracer)
+      : tracer_(tracer) {}
+
+  void OnStatsDelivered(
+      const webrtc::scoped_refptr<const webrtc::RTCStatsReport>& report)
+      override;
+
+ private:
+  std::shared_ptr<SetupTracer> tracer_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_SETUP_TRACER_H_
@@ -0,0 +1,365 @@
+#include "src/internal/shared_udp_port.h"
+
+#include <errno.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "p2p/client/basic_port_allocator.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "src/internal/stun_peek.h"
+
+namespace libwebrtc {
+
+namespace {
+
+// Checks that never get a response, e.g. because the peer left, age out.
+constexpr size_t kMaxTransactions = 16384;
+
+// Hands out sockets on the shared port instead of binding new ones.
+class SharedPortSocketFactory : public webrtc::BasicPacketSocketFactory {
+ public:
+  SharedPortSocketFactory(webrtc::SocketFactory* socket_factory,
+                          std::shared_ptr<SharedUdpPort> mux,
+                          uint64_t connection)
+      : webrtc::BasicPacketSocketFactory(socket_factory),
+        mux_(std::move(mux)),
+        connection_(connection) {}
+
+  webrtc::AsyncPacketSocket* CreateUdpSocket(
+      const webrtc::SocketAddress& address, uint16_t /* min_port */,
+      uint16_t /* max_port */) override {
+    return mux_->CreateSocket(connection_, address.ipaddr());
+  }
+
+ private:
+  std::shared_ptr<SharedUdpPort> mux_;
+  const uint64_t connection_;
+};
+
+// Constructed before the allocator base, which keeps a pointer to the
+// socket factory, and destroyed after it.
+struct SocketFactoryHolder {
+  SocketFactoryHolder(webrtc::SocketFactory* socket_factory,
+                      std::shared_ptr<SharedUdpPort> mux, uint64_t connection)
+      : shared_socket_factory(socket_factory, std::move(mux), connection) {}
+
+  SharedPortSocketFactory shared_socket_factory;
+};
+
+class SharedPortAllocator : private SocketFactoryHolder,
+                            public webrtc::BasicPortAllocator {
+ public:
+  SharedPortAllocator(const webrtc::Environment& env,
+                      webrtc::NetworkManager* network_manager,
+                      webrtc::SocketFactory* socket_factory,
+                      std::shared_ptr<SharedUdpPort> mux, uint64_t connection)
+      : SocketFactoryHolder(socket_factory, mux, connection),
+        webrtc::BasicPortAllocator(env, network_manager,
+                                   &shared_socket_factory),
+        mux_(std::move(mux)),
+        connection_(connection) {
+    // Reflexive and relayed candidates would need sockets of their own, and
+    // TCP has no shared listener. The native connection only adds flags to
+    // the ones set here.
+    set_flags(flags() | webrtc::PORTALLOCATOR_DISABLE_STUN |
+              webrtc::PORTALLOCATOR_DISABLE_RELAY |
+              webrtc::PORTALLOCATOR_DISABLE_TCP);
+  }
+
+  ~SharedPortAllocator() override { mux_->RemoveConnection(connection_); }
+
+ protected:
+  // Every session, pooled ones and ICE restarts included, brings a new
+  // ufrag. Sessions are created before they gather, so the ufrag is known
+  // before the first check for it can arrive.
+  webrtc::PortAllocatorSession* CreateSessionInternal(
+      absl::string_view content_name, int component,
+      absl::string_view ice_ufrag, absl::string_view ice_pwd) override {
+    mux_->AddUfrag(connection_, ice_ufrag);
+    return webrtc::BasicPortAllocator::CreateSessionInternal(
+        content_name, component, ice_ufrag, ice_pwd);
+  }
+
+ private:
+  std::shared_ptr<SharedUdpPort> mux_;
+  const uint64_t connection_;
+};
+
+}  // namespace
+
+struct MuxedUdpSocket::Interface {
+  std::unique_ptr<webrtc::AsyncPacketSocket> socket;
+  // Live sockets by id, and by connection oldest first. The routing tables
+  // below hold ids, entries of removed sockets miss and are dropped lazily.
+  std::unordered_map<uint64_t, MuxedUdpSocket*> sockets;
+  std::unordered_map<uint64_t, std::vector<MuxedUdpSocket*>> connections;
+  // Local ufrag to the socket checks with it were last sent from.
+  std::unordered_map<std::string, uint64_t> by_ufrag;
+  // Remote address to the socket a check was last exchanged with.
+  std::map<webrtc::SocketAddress, uint64_t> by_remote;
+  // Outstanding checks, oldest first in |transaction_order|.
+  std::unordered_map<std::string, uint64_t> transactions;
+  std::deque<std::string> transaction_order;
+};
+
+MuxedUdpSocket::MuxedUdpSocket(std::shared_ptr<SharedUdpPort> mux,
+                               Interface* interface, uint64_t connection,
+                               uint64_t id)
+    : mux_(std::move(mux)),
+      interface_(interface),
+      connection_(connection),
+      id_(id) {}
+
+MuxedUdpSocket::~MuxedUdpSocket() {
+  if (!closed_) mux_->RemoveSocket(this);
+}
+
+webrtc::SocketAddress MuxedUdpSocket::GetLocalAddress() const {
+  return interface_->socket->GetLocalAddress();
+}
+
+webrtc::SocketAddress MuxedUdpSocket::GetRemoteAddress() const {
+  return webrtc::SocketAddress();
+}
+
+int MuxedUdpSocket::Send(
+    const void* /* data */, size_t /* size */,
+    const webrtc::AsyncSocketPacketOptions& /* options */) {
+  // Like an unconnected UDP socket.
+  error_ = ENOTCONN;
+  return -1;
+}
+
+int MuxedUdpSocket::SendTo(const void* data, size_t size,
+                           const webrtc::SocketAddress& address,
+                           const webrtc::AsyncSocketPacketOptions& options) {
+  if (closed_) {
+    error_ = EBADF;
+    return -1;
+  }
+  return mux_->SendTo(this, data, size, address, options);
+}
+
+int MuxedUdpSocket::Close() {
+  if (!closed_) {
+    closed_ = true;
+    mux_->RemoveSocket(this);
+  }
+  return 0;
+}
+
+webrtc::AsyncPacketSocket::State MuxedUdpSocket::GetState() const {
+  return closed_ ? STATE_CLOSED : STATE_BOUND;
+}
+
+// Options apply to the shared socket and so to every connection on the
+// interface. The native ports only set the same buffer sizes and DSCP
+// values the factory configures for all of them.
+int MuxedUdpSocket::GetOption(webrtc::Socket::Option option, int* value) {
+  return interface_->socket->GetOption(option, value);
+}
+
+int MuxedUdpSocket::SetOption(webrtc::Socket::Option option, int value) {
+  return interface_->socket->SetOption(option, value);
+}
+
+int MuxedUdpSocket::GetError() const {
+  return error_;
+}
+
+void MuxedUdpSocket::SetError(int error) {
+  error_ = error;
+}
+
+SharedUdpPort::SharedUdpPort(const webrtc::Environment& env,
+                             webrtc::Thread* network_thread, uint16_t port)
+    : env_(env),
+      network_thread_(network_thread),
+      port_(port),
+      socket_factory_(network_thread->socketserver()),
+      network_manager_(std::make_unique<webrtc::BasicNetworkManager>(
+          env, network_thread->socketserver())) {}
+
+SharedUdpPort::~SharedUdpPort() = default;
+
+std::unique_ptr<webrtc::PortAllocator> SharedUdpPort::CreatePortAllocator() {
+  RTC_DCHECK(network_thread_->IsCurrent());
+  return std::make_unique<SharedPortAllocator>(
+      env_, network_manager_.get(), network_thread_->socketserver(),
+      shared_from_this(), next_connection_++);
+}
+
+webrtc::AsyncPacketSocket* SharedUdpPort::CreateSocket(
+    uint64_t connection, const webrtc::IPAddress& ip) {
+  Interface* interface = GetInterface(ip);
+  if (!interface) return nullptr;
+  MuxedUdpSocket* socket = new MuxedUdpSocket(shared_from_this(), interface,
+                                              connection, next_socket_++);
+  interface->sockets[socket->id()] = socket;
+  interface->connections[connection].push_back(socket);
+  return socket;
+}
+
+void SharedUdpPort::AddUfrag(uint64_t connection, absl::string_view ufrag) {
+  std::string key(ufrag);
+  ufrags_[key] = connection;
+  connection_ufrags_[connection].push_back(key);
+}
+
+void SharedUdpPort::RemoveConnection(uint64_t connection) {
+  auto it = connection_ufrags_.find(connection);
+  if (it == connection_ufrags_.end()) return;
+  for (const std::string& ufrag : it->second) {
+    auto owner = ufrags_.find(ufrag);
+    if (owner != ufrags_.end() && owner->second == connection)
+      ufrags_.erase(owner);
+  }
+  connection_ufrags_.erase(it);
+}
+
+void SharedUdpPort::RemoveSocket(MuxedUdpSocket* socket) {
+  Interface* interface = socket->interface();
+  interface->sockets.erase(socket->id());
+  auto it = interface->connections.find(socket->connection());
+  if (it == interface->connections.end()) return;
+  std::vector<MuxedUdpSocket*>& sockets = it->second;
+  sockets.erase(std::remove(sockets.begin(), sockets.end(), socket),
+                sockets.end());
+  if (sockets.empty()) interface->connections.erase(it);
+}
+
+int SharedUdpPort::SendTo(MuxedUdpSocket* socket, const void* data,
+                          size_t size, const webrtc::SocketAddress& address,
+                          const webrtc::AsyncSocketPacketOptions& options) {
+  Interface* interface = socket->interface();
+  StunPeek stun;
+  if (PeekStun(static_cast<const uint8_t*>(data), size, &stun) &&
+      stun.request) {
+    if (interface->transaction_order.size() >= kMaxTransactions) {
+      interface->transactions.erase(interface->transaction_order.front());
+      interface->transaction_order.pop_front();
+    }
+    interface->transactions[stun.transaction_id] = socket->id();
+    interface->transaction_order.push_back(stun.transaction_id);
+    interface->by_remote[address] = socket->id();
+    std::string ufrag = SenderUfrag(stun.username);
+    if (!ufrag.empty()) interface->by_ufrag[ufrag] = socket->id();
+  }
+
+  sending_ = socket;
+  int result = interface->socket->SendTo(data, size, address, options);
+  sending_ = nullptr;
+  if (result < 0) socket->SetError(interface->socket->GetError());
+  return result;
+}
+
+SharedUdpPort::Interface* SharedUdpPort::GetInterface(
+    const webrtc::IPAddress& ip) {
+  auto it = interfaces_.find(ip);
+  if (it != interfaces_.end()) return it->second.get();
+
+  // min_port and max_port 0 bind to the port of the address.
+  std::unique_ptr<webrtc::AsyncPacketSocket> socket(
+      socket_factory_.CreateUdpSocket(webrtc::SocketAddress(ip, port_), 0,
+                                      0));
+  if (!socket) {
+    RTC_LOG(LS_ERROR) << "Failed to bind the shared UDP port " << port_
+                      << " on " << ip.ToSensitiveString();
+    return nullptr;
+  }
+  std::unique_ptr<Interface> interface = std::make_unique<Interface>();
+  Interface* raw = interface.get();
+  socket->RegisterReceivedPacketCallback(
+      [this, raw](webrtc::AsyncPacketSocket* /* socket */,
+                  const webrtc::ReceivedIpPacket& packet) {
+        OnPacket(raw, packet);
+      });
+  socket->SignalSentPacket.connect(this, &SharedUdpPort::OnSentPacket);
+  socket->SignalReadyToSend.connect(this, &SharedUdpPort::OnReadyToSend);
+  interface->socket = std::move(socket);
+  interfaces_[ip] = std::move(interface);
+  return raw;
+}
+
+MuxedUdpSocket* SharedUdpPort::FindSocket(Interface* interface,
+                                          uint64_t id) {
+  auto it = interface->sockets.find(id);
+  return it == interface->sockets.end() ? nullptr : it->second;
+}
+
+MuxedUdpSocket* SharedUdpPort::FindByUfrag(Interface* interface,
+                                           const std::string& ufrag) {
+  if (ufrag.empty()) return nullptr;
+  auto learned = interface->by_ufrag.find(ufrag);
+  if (learned != interface->by_ufrag.end()) {
+    MuxedUdpSocket* socket = FindSocket(interface, learned->second);
+    if (socket) return socket;
+    interface->by_ufrag.erase(learned);
+  }
+  // No check sent with this ufrag yet, e.g. an ICE-lite connection that
+  // waits for the client. The newest session of the connection is the one
+  // being negotiated.
+  auto owner = ufrags_.find(ufrag);
+  if (owner == ufrags_.end()) return nullptr;
+  auto sockets = interface->connections.find(owner->second);
+  if (sockets == interface->connections.end()) return nullptr;
+  return sockets->second.back();
+}
+
+void SharedUdpPort::OnPacket(Interface* interface,
+                             const webrtc::ReceivedIpPacket& packet) {
+  MuxedUdpSocket* target = nullptr;
+  StunPeek stun;
+  if (PeekStun(packet.payload().data(), packet.payload().size(), &stun)) {
+    if (stun.response) {
+      auto it = interface->transactions.find(stun.transaction_id);
+      if (it != interface->transactions.end()) {
+        target = FindSocket(interface, it->second);
+        interface->transactions.erase(it);
+      }
+    } else if (stun.request) {
+      target = FindByUfrag(interface, ReceiverUfrag(stun.username));
+      if (target)
+        interface->by_remote[packet.source_address()] = target->id();
+    }
+  }
+
+  if (!target) {
+    auto it = interface->by_remote.find(packet.source_address());
+    if (it != interface->by_remote.end()) {
+      target = FindSocket(interface, it->second);
+      if (!target) interface->by_remote.erase(it);
+    }
+  }
+
+  if (!target) {
+    RTC_LOG(LS_VERBOSE) << "Dropping packet from unknown peer "
+                        << packet.source_address().ToSensitiveString()
+                        << " on the shared UDP port";
+    return;
+  }
+  target->DeliverPacket(packet);
+}
+
+void SharedUdpPort::OnSentPacket(webrtc::AsyncPacketSocket* /* socket */,
+                                 const webrtc::SentPacketInfo& sent_packet) {
+  if (sending_) sending_->DeliverSentPacket(sent_packet);
+}
+
+void SharedUdpPort::OnReadyToSend(webrtc::AsyncPacketSocket* socket) {
+  for (auto& entry : interfaces_) {
+    Interface* interface = entry.second.get();
+    if (interface->socket.get() != socket) continue;
+    // Copied, a socket may be closed from its handler.
+    std::vector<uint64_t> ids;
+    for (const auto& live : interface->sockets) ids.push_back(live.first);
+    for (uint64_t id : ids) {
+      MuxedUdpSocket* target = FindSocket(interface, id);
+      if (target) target->DeliverReadyToSend();
+    }
+  }
+}
+
+}  // namespace libwebrtc
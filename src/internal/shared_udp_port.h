@@ -0,0 +1,133 @@
+#ifndef INTERNAL_SHARED_UDP_PORT_H_
+#define INTERNAL_SHARED_UDP_PORT_H_
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "api/environment/environment.h"
+#include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/port_allocator.h"
+#include "rtc_base/async_packet_socket.h"
+#include "rtc_base/ip_address.h"
+#include "rtc_base/network.h"
+#include "rtc_base/network/received_packet.h"
+#include "rtc_base/network/sent_packet.h"
+#include "rtc_base/socket_address.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
+
+namespace libwebrtc {
+
+class SharedUdpPort;
+
+// The socket a UDP port of one connection sees. Sends go out through the
+// shared socket of its interface, receives are the packets the shared port
+// routed to it.
+class MuxedUdpSocket : public webrtc::AsyncPacketSocket {
+ public:
+  struct Interface;
+
+  MuxedUdpSocket(std::shared_ptr<SharedUdpPort> mux, Interface* interface,
+                 uint64_t connection, uint64_t id);
+  ~MuxedUdpSocket() override;
+
+  Interface* interface() const { return interface_; }
+  uint64_t connection() const { return connection_; }
+  uint64_t id() const { return id_; }
+
+  void DeliverPacket(const webrtc::ReceivedIpPacket& packet) {
+    NotifyPacketReceived(packet);
+  }
+  void DeliverSentPacket(const webrtc::SentPacketInfo& sent_packet) {
+    SignalSentPacket(this, sent_packet);
+  }
+  void DeliverReadyToSend() { SignalReadyToSend(this); }
+
+  webrtc::SocketAddress GetLocalAddress() const override;
+  webrtc::SocketAddress GetRemoteAddress() const override;
+  int Send(const void* data, size_t size,
+           const webrtc::AsyncSocketPacketOptions& options) override;
+  int SendTo(const void* data, size_t size,
+             const webrtc::SocketAddress& address,
+             const webrtc::AsyncSocketPacketOptions& options) override;
+  int Close() override;
+  State GetState() const override;
+  int GetOption(webrtc::Socket::Option option, int* value) override;
+  int SetOption(webrtc::Socket::Option option, int value) override;
+  int GetError() const override;
+  void SetError(int error) override;
+
+ private:
+  std::shared_ptr<SharedUdpPort> mux_;
+  Interface* interface_;
+  const uint64_t connection_;
+  const uint64_t id_;
+  bool closed_ = false;
+  int error_ = 0;
+};
+
+// One UDP socket per local address, all bound to the same port and shared
+// by the connections of a factory. Connectivity checks are routed by the
+// ICE ufrag in their USERNAME, STUN responses by transaction id and
+// everything else by the remote address a check last came from or went to.
+// Only used on the network thread.
+class SharedUdpPort : public std::enable_shared_from_this<SharedUdpPort>,
+                      public sigslot::has_slots<> {
+ public:
+  SharedUdpPort(const webrtc::Environment& env,
+                webrtc::Thread* network_thread, uint16_t port);
+  ~SharedUdpPort();
+
+  uint16_t port() const { return port_; }
+
+  // Port allocator of one connection. It gathers host candidates on the
+  // shared port only and registers every ufrag the connection uses.
+  std::unique_ptr<webrtc::PortAllocator> CreatePortAllocator();
+
+  // Used by the allocators and sockets handed out above.
+  webrtc::AsyncPacketSocket* CreateSocket(uint64_t connection,
+                                          const webrtc::IPAddress& ip);
+  void AddUfrag(uint64_t connection, absl::string_view ufrag);
+  void RemoveConnection(uint64_t connection);
+  void RemoveSocket(MuxedUdpSocket* socket);
+  int SendTo(MuxedUdpSocket* socket, const void* data, size_t size,
+             const webrtc::SocketAddress& address,
+             const webrtc::AsyncSocketPacketOptions& options);
+
+ private:
+  using Interface = MuxedUdpSocket::Interface;
+
+  Interface* GetInterface(const webrtc::IPAddress& ip);
+  MuxedUdpSocket* FindSocket(Interface* interface, uint64_t id);
+  MuxedUdpSocket* FindByUfrag(Interface* interface, const std::string& ufrag);
+  void OnPacket(Interface* interface, const webrtc::ReceivedIpPacket& packet);
+  void OnSentPacket(webrtc::AsyncPacketSocket* socket,
+                    const webrtc::SentPacketInfo& sent_packet);
+  void OnReadyToSend(webrtc::AsyncPacketSocket* socket);
+
+  const webrtc::Environment env_;
+  webrtc::Thread* network_thread_;
+  const uint16_t port_;
+  webrtc::BasicPacketSocketFactory socket_factory_;
+  std::unique_ptr<webrtc::NetworkManager> network_manager_;
+  std::map<webrtc::IPAddress, std::unique_ptr<Interface>> interfaces_;
+  // Ufrag to the connection that owns it.
+  std::unordered_map<std::string, uint64_t> ufrags_;
+  std::unordered_map<uint64_t, std::vector<std::string>> connection_ufrags_;
+  uint64_t next_connection_ = 1;
+  uint64_t next_socket_ = 1;
+  // Socket whose send is in progress, the shared socket reports the sent
+  // packet synchronously.
+  MuxedUdpSocket* sending_ = nullptr;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_SHARED_UDP_PORT_H_
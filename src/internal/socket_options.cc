@@ -0,0 +1,80 @@
+#include "src/internal/socket_options.h"
+
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "rtc_base/logging.h"
+#include "src/internal/udp_counters.h"
+#include "system_wrappers/include/field_trial.h"
+
+namespace libwebrtc {
+
+namespace {
+
+constexpr char kSendBufferTrial[] = "WebRTC-SendBufferSizeBytes";
+constexpr char kReceiveBufferTrial[] = "WebRTC-ReceiveBufferSize";
+
+void AddTrial(const char* name, const std::string& group,
+              std::string* trials) {
+  if (!webrtc::field_trial::FindFullName(name).empty()) {
+    RTC_LOG(LS_WARNING) << name << " is already set, keeping "
+                        << webrtc::field_trial::FindFullName(name);
+    return;
+  }
+  *trials += std::string(name) + "/" + group + "/";
+}
+
+void InstallTrials(int send_buffer_size, int receive_buffer_size) {
+  if (send_buffer_size <= 0 && receive_buffer_size <= 0) return;
+
+  const char* current = webrtc::field_trial::GetFieldTrialString();
+  std::string trials = current ? current : "";
+  if (send_buffer_size > 0)
+    AddTrial(kSendBufferTrial, std::to_string(send_buffer_size), &trials);
+  if (receive_buffer_size > 0) {
+    AddTrial(kReceiveBufferTrial,
+             "size_bytes:" + std::to_string(receive_buffer_size), &trials);
+  }
+  if (current && trials == current) return;
+
+  // The native code keeps the pointer. Installed once per process, the
+  // string is never freed.
+  std::string* installed = new std::string(trials);
+  webrtc::field_trial::InitFieldTrialsFromString(installed->c_str());
+}
+
+}  // namespace
+
+void InstallSocketBufferSizes(int send_buffer_size, int receive_buffer_size) {
+  // Field trials are read without locking by the threads of every factory,
+  // so they are only replaced once, before the first factory starts.
+  static std::once_flag once;
+  static int installed_send_buffer_size = 0;
+  static int installed_receive_buffer_size = 0;
+  std::call_once(once, [&] {
+    installed_send_buffer_size = send_buffer_size;
+    installed_receive_buffer_size = receive_buffer_size;
+    InstallTrials(send_buffer_size, receive_buffer_size);
+  });
+  if (send_buffer_size != installed_send_buffer_size ||
+      receive_buffer_size != installed_receive_buffer_size) {
+    RTC_LOG(LS_WARNING) << "Socket buffer sizes are set by the first factory, "
+                           "ignoring "
+                        << send_buffer_size << "/" << receive_buffer_size;
+  }
+}
+
+RTCUdpDropCounters ReadUdpDropCounters() {
+  RTCUdpDropCounters counters;
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+  std::ifstream snmp("/proc/net/snmp");
+  bool ipv4 = ParseSnmpUdp(snmp, &counters);
+  std::ifstream snmp6("/proc/net/snmp6");
+  bool ipv6 = ParseSnmp6Udp(snmp6, &counters);
+  counters.available = ipv4 || ipv6;
+#endif
+  return counters;
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,20 @@
+#ifndef INTERNAL_SOCKET_OPTIONS_H_
+#define INTERNAL_SOCKET_OPTIONS_H_
+
+#include "rtc_peerconnection_factory.h"
+
+namespace libwebrtc {
+
+// Adds the field trials the native video channels read their RTP socket
+// buffer sizes from to the global field trial string. 0 keeps the native
+// default. Must run before the native factory is created. Only the first
+// call in the process has an effect, later ones with other sizes are logged
+// and ignored.
+void InstallSocketBufferSizes(int send_buffer_size, int receive_buffer_size);
+
+// Reads the UDP counters from /proc/net/snmp and /proc/net/snmp6.
+RTCUdpDropCounters ReadUdpDropCounters();
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_SOCKET_OPTIONS_H_
@@ -0,0 +1,84 @@
+#ifndef INTERNAL_STUN_PEEK_H_
+#define INTERNAL_STUN_PEEK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace libwebrtc {
+
+// What the shared UDP port needs from a STUN message to route it, read
+// without parsing or validating the whole message.
+struct StunPeek {
+  // Request class, e.g. an ICE connectivity check.
+  bool request = false;
+  // Success or error response class.
+  bool response = false;
+  // The 12 byte transaction id.
+  std::string transaction_id;
+  // Value of the USERNAME attribute, empty if there is none.
+  std::string username;
+};
+
+constexpr uint32_t kStunMagicCookie = 0x2112A442;
+constexpr size_t kStunHeaderSize = 20;
+constexpr uint16_t kStunUsernameAttribute = 0x0006;
+
+inline uint16_t ReadStunUint16(const uint8_t* data) {
+  return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+// Returns false if |data| is not a STUN message. DTLS, RTP and RTCP never
+// carry the magic cookie at the same offset with a matching length.
+inline bool PeekStun(const uint8_t* data, size_t size, StunPeek* peek) {
+  if (size < kStunHeaderSize || (data[0] & 0xC0) != 0) return false;
+  uint16_t type = ReadStunUint16(data);
+  size_t length = ReadStunUint16(data + 2);
+  uint32_t cookie = (static_cast<uint32_t>(data[4]) << 24) |
+                    (static_cast<uint32_t>(data[5]) << 16) |
+                    (static_cast<uint32_t>(data[6]) << 8) | data[7];
+  if (cookie != kStunMagicCookie || length % 4 != 0 ||
+      kStunHeaderSize + length != size)
+    return false;
+
+  // The class is split over bits 8 and 4 of the type.
+  int message_class = ((type >> 7) & 0x2) | ((type >> 4) & 0x1);
+  peek->request = message_class == 0;
+  peek->response = message_class >= 2;
+  peek->transaction_id.assign(reinterpret_cast<const char*>(data + 8), 12);
+  peek->username.clear();
+
+  size_t offset = kStunHeaderSize;
+  while (offset + 4 <= size) {
+    uint16_t attribute = ReadStunUint16(data + offset);
+    size_t attribute_length = ReadStunUint16(data + offset + 2);
+    offset += 4;
+    if (offset + attribute_length > size) return false;
+    if (attribute == kStunUsernameAttribute) {
+      peek->username.assign(reinterpret_cast<const char*>(data + offset),
+                            attribute_length);
+      break;
+    }
+    // Values are padded to a multiple of 4 bytes.
+    offset += (attribute_length + 3) & ~static_cast<size_t>(3);
+  }
+  return true;
+}
+
+// USERNAME of a connectivity check is "<receiver ufrag>:<sender ufrag>".
+inline std::string ReceiverUfrag(const std::string& username) {
+  size_t colon = username.find(':');
+  return colon == std::string::npos ? std::string()
+                                    : username.substr(0, colon);
+}
+
+inline std::string SenderUfrag(const std::string& username) {
+  size_t colon = username.find(':');
+  return colon == std::string::npos ? std::string()
+                                    : username.substr(colon + 1);
+}
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_STUN_PEEK_H_
@@ -0,0 +1,118 @@
+#include "src/internal/thread_options.h"
+
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+namespace {
+
+bool ApplyToCurrentThread(const RTCThreadOptions& options) {
+  bool ok = true;
+#if defined(WEBRTC_WIN)
+  if (options.cpu_mask != 0 &&
+      !SetThreadAffinityMask(GetCurrentThread(),
+                             static_cast<DWORD_PTR>(options.cpu_mask))) {
+    RTC_LOG(LS_WARNING) << "SetThreadAffinityMask failed: " << GetLastError();
+    ok = false;
+  }
+  int priority = THREAD_PRIORITY_NORMAL;
+  if (options.policy != RTCThreadSchedulingPolicy::kDefault) {
+    priority = THREAD_PRIORITY_TIME_CRITICAL;
+  } else if (options.nice <= -10) {
+    priority = THREAD_PRIORITY_HIGHEST;
+  } else if (options.nice < 0) {
+    priority = THREAD_PRIORITY_ABOVE_NORMAL;
+  } else if (options.nice >= 10) {
+    priority = THREAD_PRIORITY_LOWEST;
+  } else if (options.nice > 0) {
+    priority = THREAD_PRIORITY_BELOW_NORMAL;
+  }
+  if (priority != THREAD_PRIORITY_NORMAL &&
+      !SetThreadPriority(GetCurrentThread(), priority)) {
+    RTC_LOG(LS_WARNING) << "SetThreadPriority failed: " << GetLastError();
+    ok = false;
+  }
+#else
+  if (options.policy != RTCThreadSchedulingPolicy::kDefault) {
+    int policy = options.policy == RTCThreadSchedulingPolicy::kFifo
+                     ? SCHED_FIFO
+                     : SCHED_RR;
+    // Real-time policies reject priority 0, use the lowest one instead.
+    int min_priority = sched_get_priority_min(policy);
+    int max_priority = sched_get_priority_max(policy);
+    int priority = options.priority == 0 ? min_priority : options.priority;
+    if (priority < min_priority || priority > max_priority) {
+      RTC_LOG(LS_WARNING) << "Real-time priority " << priority
+                          << " is outside " << min_priority << ".."
+                          << max_priority;
+      ok = false;
+    } else {
+      sched_param param = {};
+      param.sched_priority = priority;
+      int error = pthread_setschedparam(pthread_self(), policy, &param);
+      if (error != 0) {
+        RTC_LOG(LS_WARNING) << "pthread_setschedparam failed: " << error;
+        ok = false;
+      }
+    }
+  }
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+  // On Linux the nice value and the affinity are per thread.
+  if (options.nice != 0 &&
+      setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)),
+                  options.nice) != 0) {
+    RTC_LOG_ERRNO(LS_WARNING) << "setpriority failed";
+    ok = false;
+  }
+  if (options.cpu_mask != 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < 64; cpu++) {
+      if (options.cpu_mask & (uint64_t(1) << cpu)) CPU_SET(cpu, &cpus);
+    }
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+      RTC_LOG_ERRNO(LS_WARNING) << "sched_setaffinity failed";
+      ok = false;
+    }
+  }
+#else
+  if (options.nice != 0 || options.cpu_mask != 0) {
+    RTC_LOG(LS_WARNING) << "Per-thread nice and CPU affinity are not "
+                           "supported on this platform";
+    ok = false;
+  }
+#endif
+#endif
+  return ok;
+}
+
+}  // namespace
+
+std::string ThreadName(const RTCThreadOptions& options,
+                       const std::string& default_name) {
+  std::string name = options.name.std_string();
+  return name.empty() ? default_name : name;
+}
+
+bool ApplyThreadOptions(webrtc::Thread* thread,
+                        const RTCThreadOptions& options) {
+  if (options.nice == 0 && options.cpu_mask == 0 &&
+      options.policy == RTCThreadSchedulingPolicy::kDefault) {
+    return true;
+  }
+  return thread->BlockingCall([&] { return ApplyToCurrentThread(options); });
+}
+
+}  // namespace libwebrtc
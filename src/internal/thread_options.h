@@ -0,0 +1,22 @@
+#ifndef INTERNAL_THREAD_OPTIONS_H_
+#define INTERNAL_THREAD_OPTIONS_H_
+
+#include <string>
+
+#include "rtc_base/thread.h"
+#include "rtc_peerconnection_factory.h"
+
+namespace libwebrtc {
+
+// Returns |options.name| if set, |default_name| otherwise.
+std::string ThreadName(const RTCThreadOptions& options,
+                       const std::string& default_name);
+
+// Applies priority and affinity from |options| to the started |thread|.
+// Returns false if any of the settings could not be applied.
+bool ApplyThreadOptions(webrtc::Thread* thread,
+                        const RTCThreadOptions& options);
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_THREAD_OPTIONS_H_
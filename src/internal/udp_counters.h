@@ -0,0 +1,74 @@
+#ifndef INTERNAL_UDP_COUNTERS_H_
+#define INTERNAL_UDP_COUNTERS_H_
+
+#include <stdint.h>
+
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rtc_peerconnection_factory.h"
+
+namespace libwebrtc {
+
+// Adds |value| to the counter called |name| in the kernel's naming, other
+// names are ignored.
+inline void AddUdpCounter(const std::string& name, uint64_t value,
+                          RTCUdpDropCounters* counters) {
+  if (name == "InDatagrams") {
+    counters->in_datagrams += value;
+  } else if (name == "OutDatagrams") {
+    counters->out_datagrams += value;
+  } else if (name == "RcvbufErrors") {
+    counters->receive_buffer_errors += value;
+  } else if (name == "SndbufErrors") {
+    counters->send_buffer_errors += value;
+  } else if (name == "InErrors") {
+    counters->in_errors += value;
+  }
+}
+
+// Parses /proc/net/snmp, which has two "Udp:" lines, the field names
+// followed by the values. Returns false if no values were found.
+inline bool ParseSnmpUdp(std::istream& in, RTCUdpDropCounters* counters) {
+  std::vector<std::string> names;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 4, "Udp:") != 0) continue;
+    std::istringstream fields(line.substr(4));
+    if (names.empty()) {
+      std::string name;
+      while (fields >> name) names.push_back(name);
+      continue;
+    }
+    for (const std::string& name : names) {
+      uint64_t value = 0;
+      if (!(fields >> value)) break;
+      AddUdpCounter(name, value, counters);
+    }
+    return true;
+  }
+  return false;
+}
+
+// Parses /proc/net/snmp6, which has one "Udp6<name> <value>" line per
+// counter. Returns false if there was none.
+inline bool ParseSnmp6Udp(std::istream& in, RTCUdpDropCounters* counters) {
+  bool found = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 4, "Udp6") != 0) continue;
+    std::istringstream fields(line);
+    std::string name;
+    uint64_t value = 0;
+    if (!(fields >> name >> value)) continue;
+    AddUdpCounter(name.substr(4), value, counters);
+    found = true;
+  }
+  return found;
+}
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_UDP_COUNTERS_H_
@@ -1,6 +1,7 @@
 #include "libwebrtc.h"
 
 #include "api/scoped_refptr.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/ssl_adapter.h"
 #include "rtc_base/thread.h"
 #include "rtc_peerconnection_factory_impl.h"
@@ -21,6 +22,7 @@ bool LibWebRTC::Initialize() {
 
 // Stops and cleans up the threads and SSL.
 void LibWebRTC::Terminate() {
+  RTCPeerConnectionFactoryImpl::JoinRetiredThreads();
   webrtc::ThreadManager::Instance()->SetCurrentThread(NULL);
   webrtc::CleanupSSL();
 
@@ -31,10 +33,19 @@ void LibWebRTC::Terminate() {
 // Creates and returns an instance of RTCPeerConnectionFactory.
 scoped_refptr<RTCPeerConnectionFactory>
 LibWebRTC::CreateRTCPeerConnectionFactory() {
+  return CreateRTCPeerConnectionFactory(RTCPeerConnectionFactoryOptions());
+}
+
+scoped_refptr<RTCPeerConnectionFactory>
+LibWebRTC::CreateRTCPeerConnectionFactory(
+    const RTCPeerConnectionFactoryOptions& options) {
   scoped_refptr<RTCPeerConnectionFactory> rtc_peerconnection_factory =
       scoped_refptr<RTCPeerConnectionFactory>(
-          new RefCountedObject<RTCPeerConnectionFactoryImpl>());
-  rtc_peerconnection_factory->Initialize();
+          new RefCountedObject<RTCPeerConnectionFactoryImpl>(options));
+  if (!rtc_peerconnection_factory->Initialize()) {
+    RTC_LOG(LS_ERROR) << "Failed to initialize the peer connection factory";
+    return nullptr;
+  }
   return rtc_peerconnection_factory;
 }
 
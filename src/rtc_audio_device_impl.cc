@@ -9,9 +9,16 @@ AudioDeviceImpl::AudioDeviceImpl(
     webrtc::Thread* worker_thread)
     : audio_device_module_(audio_device_module), worker_thread_(worker_thread) {
   audio_device_module_->SetObserver(this);
+  // A task holding a reference can't be posted before the creator has
+  // taken its own, fill the lists synchronously instead.
+  worker_thread_->BlockingCall([this] {
+    RTC_DCHECK_RUN_ON(worker_thread_);
+    RefreshDeviceLists_w();
+  });
 }
 
 AudioDeviceImpl::~AudioDeviceImpl() {
+  audio_device_module_->SetObserver(nullptr);
   RTC_LOG(LS_INFO) << __FUNCTION__ << ": dtor ";
 }
 
@@ -42,30 +49,32 @@ int32_t AudioDeviceImpl::RecordingDeviceName(uint16_t index,
 }
 
 int32_t AudioDeviceImpl::SetPlayoutDevice(uint16_t index) {
-  worker_thread_->PostTask([this, index] {
-    RTC_DCHECK_RUN_ON(worker_thread_);
-    if (audio_device_module_->Playing()) {
-      audio_device_module_->StopPlayout();
-      audio_device_module_->SetPlayoutDevice(index);
-      audio_device_module_->InitPlayout();
-      audio_device_module_->StartPlayout();
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, index] {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    if (self->audio_device_module_->Playing()) {
+      self->audio_device_module_->StopPlayout();
+      self->audio_device_module_->SetPlayoutDevice(index);
+      self->audio_device_module_->InitPlayout();
+      self->audio_device_module_->StartPlayout();
     } else {
-      audio_device_module_->SetPlayoutDevice(index);
+      self->audio_device_module_->SetPlayoutDevice(index);
     }
   });
   return 0;
 }
 
 int32_t AudioDeviceImpl::SetRecordingDevice(uint16_t index) {
-  worker_thread_->PostTask([this, index] {
-    RTC_DCHECK_RUN_ON(worker_thread_);
-    if (audio_device_module_->Recording()) {
-      audio_device_module_->StopRecording();
-      audio_device_module_->SetRecordingDevice(index);
-      audio_device_module_->InitRecording();
-      audio_device_module_->StartRecording();
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, index] {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    if (self->audio_device_module_->Recording()) {
+      self->audio_device_module_->StopRecording();
+      self->audio_device_module_->SetRecordingDevice(index);
+      self->audio_device_module_->InitRecording();
+      self->audio_device_module_->StartRecording();
     } else {
-      audio_device_module_->SetRecordingDevice(index);
+      self->audio_device_module_->SetRecordingDevice(index);
     }
   });
   return 0;
@@ -101,13 +110,130 @@ int32_t AudioDeviceImpl::SpeakerVolume(uint32_t& volume) {
   });
 }
 
+vector<RTCAudioDevice::DeviceInfo> AudioDeviceImpl::PlayoutDeviceList() {
+  webrtc::MutexLock lock(&device_list_mutex_);
+  return playout_devices_;
+}
+
+vector<RTCAudioDevice::DeviceInfo> AudioDeviceImpl::RecordingDeviceList() {
+  webrtc::MutexLock lock(&device_list_mutex_);
+  return recording_devices_;
+}
+
+void AudioDeviceImpl::PlayoutDeviceNameAsync(uint16_t index,
+                                             OnDeviceNameCallback callback) {
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, index, callback]() mutable {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    char name[kAdmMaxDeviceNameSize] = {0};
+    char guid[kAdmMaxGuidSize] = {0};
+    int32_t result =
+        self->audio_device_module_->PlayoutDeviceName(index, name, guid);
+    callback(result, name, guid);
+  });
+}
+
+void AudioDeviceImpl::RecordingDeviceNameAsync(uint16_t index,
+                                               OnDeviceNameCallback callback) {
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, index, callback]() mutable {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    char name[kAdmMaxDeviceNameSize] = {0};
+    char guid[kAdmMaxGuidSize] = {0};
+    int32_t result =
+        self->audio_device_module_->RecordingDeviceName(index, name, guid);
+    callback(result, name, guid);
+  });
+}
+
+void AudioDeviceImpl::SetMicrophoneVolumeAsync(uint32_t volume,
+                                               OnResultCallback callback) {
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, volume, callback]() mutable {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    callback(self->audio_device_module_->SetMicrophoneVolume(volume));
+  });
+}
+
+void AudioDeviceImpl::MicrophoneVolumeAsync(OnVolumeCallback callback) {
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, callback]() mutable {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    uint32_t volume = 0;
+    int32_t result = self->audio_device_module_->MicrophoneVolume(&volume);
+    callback(result, volume);
+  });
+}
+
+void AudioDeviceImpl::SetSpeakerVolumeAsync(uint32_t volume,
+                                            OnResultCallback callback) {
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, volume, callback]() mutable {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    callback(self->audio_device_module_->SetSpeakerVolume(volume));
+  });
+}
+
+void AudioDeviceImpl::SpeakerVolumeAsync(OnVolumeCallback callback) {
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self, callback]() mutable {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    uint32_t volume = 0;
+    int32_t result = self->audio_device_module_->SpeakerVolume(&volume);
+    callback(result, volume);
+  });
+}
+
+void AudioDeviceImpl::RefreshDeviceLists_w() {
+  std::vector<DeviceInfo> playout_devices;
+  std::vector<DeviceInfo> recording_devices;
+  char name[kAdmMaxDeviceNameSize];
+  char guid[kAdmMaxGuidSize];
+
+  int16_t count = audio_device_module_->PlayoutDevices();
+  for (int16_t i = 0; i < count; i++) {
+    if (audio_device_module_->PlayoutDeviceName(i, name, guid) == 0) {
+      playout_devices.push_back({name, guid});
+    }
+  }
+
+  count = audio_device_module_->RecordingDevices();
+  for (int16_t i = 0; i < count; i++) {
+    if (audio_device_module_->RecordingDeviceName(i, name, guid) == 0) {
+      recording_devices.push_back({name, guid});
+    }
+  }
+
+  webrtc::MutexLock lock(&device_list_mutex_);
+  playout_devices_.swap(playout_devices);
+  recording_devices_.swap(recording_devices);
+}
+
+int32_t AudioDeviceImpl::GetLatencyStats(int32_t& playout_delay_ms,
+                                         int32_t& playout_underruns) {
+  return worker_thread_->BlockingCall([&] {
+    RTC_DCHECK_RUN_ON(worker_thread_);
+    uint16_t delay_ms = 0;
+    playout_delay_ms = audio_device_module_->PlayoutDelay(&delay_ms) == 0
+                           ? static_cast<int32_t>(delay_ms)
+                           : -1;
+    playout_underruns = audio_device_module_->GetPlayoutUnderrunCount();
+    return 0;
+  });
+}
+
 int32_t AudioDeviceImpl::OnDeviceChange(OnDeviceChangeCallback listener) {
   listener_ = listener;
   return 0;
 }
 
 void AudioDeviceImpl::OnDevicesUpdated() {
-  if (listener_) listener_();
+  scoped_refptr<AudioDeviceImpl> self(this);
+  worker_thread_->PostTask([self] {
+    RTC_DCHECK_RUN_ON(self->worker_thread_);
+    self->RefreshDeviceLists_w();
+    if (self->listener_) self->listener_();
+  });
 }
 
 }  // namespace libwebrtc
@@ -1,10 +1,13 @@
 #ifndef LIB_WEBRTC_AUDIO_DEVICE_IMPL_HXX
 #define LIB_WEBRTC_AUDIO_DEVICE_IMPL_HXX
 
+#include <vector>
+
 #include "modules/audio_device/audio_device_impl.h"
 #include "modules/audio_device/include/audio_device.h"
 #include "rtc_audio_device.h"
 #include "rtc_base/ref_count.h"
+#include "rtc_base/synchronization/mutex.h"
 #include "rtc_base/thread.h"
 
 namespace libwebrtc {
@@ -41,13 +44,41 @@ class AudioDeviceImpl : public RTCAudioDevice, public webrtc::AudioDeviceObserve
 
   int32_t OnDeviceChange(OnDeviceChangeCallback listener) override;
 
+  vector<DeviceInfo> PlayoutDeviceList() override;
+
+  vector<DeviceInfo> RecordingDeviceList() override;
+
+  void PlayoutDeviceNameAsync(uint16_t index,
+                              OnDeviceNameCallback callback) override;
+
+  void RecordingDeviceNameAsync(uint16_t index,
+                                OnDeviceNameCallback callback) override;
+
+  void SetMicrophoneVolumeAsync(uint32_t volume,
+                                OnResultCallback callback) override;
+
+  void MicrophoneVolumeAsync(OnVolumeCallback callback) override;
+
+  void SetSpeakerVolumeAsync(uint32_t volume,
+                             OnResultCallback callback) override;
+
+  void SpeakerVolumeAsync(OnVolumeCallback callback) override;
+
+  int32_t GetLatencyStats(int32_t& playout_delay_ms,
+                          int32_t& playout_underruns) override;
+
  protected:
   void OnDevicesUpdated() override;
 
+  void RefreshDeviceLists_w();
+
  private:
   webrtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module_;
   webrtc::Thread* worker_thread_ = nullptr;
   OnDeviceChangeCallback listener_ = nullptr;
+  webrtc::Mutex device_list_mutex_;
+  std::vector<DeviceInfo> playout_devices_;
+  std::vector<DeviceInfo> recording_devices_;
 };
 
 }  // namespace libwebrtc
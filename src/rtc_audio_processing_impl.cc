@@ -104,4 +104,158 @@ void RTCAudioProcessingImpl::SetRenderPreProcessing(
   render_pre_processor_->SetExternalAudioProcessing(processor);
 }
 
+void RTCAudioProcessingImpl::SetCapturePostProcessingBypass(bool bypass) {
+  capture_post_processor_->SetBypassFlag(bypass);
+}
+
+void RTCAudioProcessingImpl::SetRenderPreProcessingBypass(bool bypass) {
+  render_pre_processor_->SetBypassFlag(bypass);
+}
+
+void RTCAudioProcessingImpl::ApplyConfig(
+    const RTCAudioProcessing::Config& config) {
+  using ApmConfig = webrtc::AudioProcessing::Config;
+  ApmConfig apm_config = apm_->GetConfig();
+
+  apm_config.echo_canceller.enabled =
+      config.echo_canceller != EchoCancellerMode::kDisabled;
+  apm_config.echo_canceller.mobile_mode =
+      config.echo_canceller == EchoCancellerMode::kMobile;
+
+  apm_config.noise_suppression.enabled =
+      config.noise_suppression != NoiseSuppressionLevel::kDisabled;
+  switch (config.noise_suppression) {
+    case NoiseSuppressionLevel::kLow:
+      apm_config.noise_suppression.level = ApmConfig::NoiseSuppression::kLow;
+      break;
+    case NoiseSuppressionLevel::kModerate:
+      apm_config.noise_suppression.level =
+          ApmConfig::NoiseSuppression::kModerate;
+      break;
+    case NoiseSuppressionLevel::kHigh:
+      apm_config.noise_suppression.level = ApmConfig::NoiseSuppression::kHigh;
+      break;
+    case NoiseSuppressionLevel::kVeryHigh:
+      apm_config.noise_suppression.level =
+          ApmConfig::NoiseSuppression::kVeryHigh;
+      break;
+    default:
+      break;
+  }
+
+  apm_config.gain_controller1.enabled =
+      config.gain_control != GainControlMode::kDisabled;
+  switch (config.gain_control) {
+    case GainControlMode::kAdaptiveAnalog:
+      apm_config.gain_controller1.mode =
+          ApmConfig::GainController1::kAdaptiveAnalog;
+      break;
+    case GainControlMode::kAdaptiveDigital:
+      apm_config.gain_controller1.mode =
+          ApmConfig::GainController1::kAdaptiveDigital;
+      break;
+    case GainControlMode::kFixedDigital:
+      apm_config.gain_controller1.mode =
+          ApmConfig::GainController1::kFixedDigital;
+      break;
+    default:
+      break;
+  }
+
+  apm_config.gain_controller2.enabled = config.gain_controller2;
+  apm_config.gain_controller2.adaptive_digital.enabled =
+      config.gain_controller2;
+
+  apm_config.high_pass_filter.enabled = config.high_pass_filter;
+
+  if (config.pipeline_max_processing_rate > 0) {
+    apm_config.pipeline.maximum_internal_processing_rate =
+        config.pipeline_max_processing_rate;
+  }
+  apm_config.pipeline.multi_channel_render = config.multi_channel_render;
+  apm_config.pipeline.multi_channel_capture = config.multi_channel_capture;
+
+  {
+    webrtc::MutexLock lock(&config_mutex_);
+    config_ = config;
+    config_applied_ = true;
+  }
+
+  RTC_LOG(LS_INFO) << __FUNCTION__ << ": " << apm_config.ToString();
+  apm_->ApplyConfig(apm_config);
+}
+
+RTCAudioProcessing::Config RTCAudioProcessingImpl::GetConfig() {
+  using ApmConfig = webrtc::AudioProcessing::Config;
+  ApmConfig apm_config = apm_->GetConfig();
+  RTCAudioProcessing::Config config;
+
+  if (!apm_config.echo_canceller.enabled) {
+    config.echo_canceller = EchoCancellerMode::kDisabled;
+  } else if (apm_config.echo_canceller.mobile_mode) {
+    config.echo_canceller = EchoCancellerMode::kMobile;
+  } else {
+    config.echo_canceller = EchoCancellerMode::kFull;
+  }
+
+  if (!apm_config.noise_suppression.enabled) {
+    config.noise_suppression = NoiseSuppressionLevel::kDisabled;
+  } else {
+    switch (apm_config.noise_suppression.level) {
+      case ApmConfig::NoiseSuppression::kLow:
+        config.noise_suppression = NoiseSuppressionLevel::kLow;
+        break;
+      case ApmConfig::NoiseSuppression::kModerate:
+        config.noise_suppression = NoiseSuppressionLevel::kModerate;
+        break;
+      case ApmConfig::NoiseSuppression::kHigh:
+        config.noise_suppression = NoiseSuppressionLevel::kHigh;
+        break;
+      case ApmConfig::NoiseSuppression::kVeryHigh:
+        config.noise_suppression = NoiseSuppressionLevel::kVeryHigh;
+        break;
+    }
+  }
+
+  if (!apm_config.gain_controller1.enabled) {
+    config.gain_control = GainControlMode::kDisabled;
+  } else {
+    switch (apm_config.gain_controller1.mode) {
+      case ApmConfig::GainController1::kAdaptiveAnalog:
+        config.gain_control = GainControlMode::kAdaptiveAnalog;
+        break;
+      case ApmConfig::GainController1::kAdaptiveDigital:
+        config.gain_control = GainControlMode::kAdaptiveDigital;
+        break;
+      case ApmConfig::GainController1::kFixedDigital:
+        config.gain_control = GainControlMode::kFixedDigital;
+        break;
+    }
+  }
+
+  config.gain_controller2 = apm_config.gain_controller2.enabled;
+  config.high_pass_filter = apm_config.high_pass_filter.enabled;
+  config.pipeline_max_processing_rate =
+      apm_config.pipeline.maximum_internal_processing_rate;
+  config.multi_channel_render = apm_config.pipeline.multi_channel_render;
+  config.multi_channel_capture = apm_config.pipeline.multi_channel_capture;
+  return config;
+}
+
+webrtc::AudioOptions RTCAudioProcessingImpl::GetAudioOptions() {
+  webrtc::AudioOptions options;
+  webrtc::MutexLock lock(&config_mutex_);
+  if (!config_applied_) {
+    return options;
+  }
+  options.echo_cancellation =
+      config_.echo_canceller != EchoCancellerMode::kDisabled;
+  options.noise_suppression =
+      config_.noise_suppression != NoiseSuppressionLevel::kDisabled;
+  options.auto_gain_control =
+      config_.gain_control != GainControlMode::kDisabled;
+  options.highpass_filter = config_.high_pass_filter;
+  return options;
+}
+
 }  // namespace libwebrtc
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include <memory>
 
+#include "api/audio_options.h"
 #include "modules/audio_processing/include/audio_processing.h"
+#include "rtc_base/synchronization/mutex.h"
 #include "rtc_audio_processing.h"
 
 namespace libwebrtc {
@@ -20,6 +22,18 @@ class RTCAudioProcessingImpl : public RTCAudioProcessing {
   void SetRenderPreProcessing(
       RTCAudioProcessing::CustomProcessing* render_pre_processing) override;
 
+  void SetCapturePostProcessingBypass(bool bypass) override;
+
+  void SetRenderPreProcessingBypass(bool bypass) override;
+
+  void ApplyConfig(const RTCAudioProcessing::Config& config) override;
+
+  RTCAudioProcessing::Config GetConfig() override;
+
+  // AudioOptions matching the current config, so the voice engine does not
+  // re-enable stages that were switched off through ApplyConfig().
+  webrtc::AudioOptions GetAudioOptions();
+
   virtual webrtc::scoped_refptr<webrtc::AudioProcessing> GetAudioProcessing() {
     return apm_;
   }
@@ -28,6 +42,9 @@ class RTCAudioProcessingImpl : public RTCAudioProcessing {
   CustomProcessingAdapter* capture_post_processor_;
   CustomProcessingAdapter* render_pre_processor_;
   webrtc::scoped_refptr<webrtc::AudioProcessing> apm_;
+  webrtc::Mutex config_mutex_;
+  RTCAudioProcessing::Config config_;
+  bool config_applied_ = false;
 };
 
 }  // namespace libwebrtc
@@ -0,0 +1,33 @@
+#include "rtc_data_buffer_impl.h"
+
+namespace libwebrtc {
+
+scoped_refptr<RTCDataBuffer> RTCDataBuffer::Create(size_t size, bool binary) {
+  webrtc::CopyOnWriteBuffer data(size);
+  return scoped_refptr<RTCDataBufferImpl>(
+      new RefCountedObject<RTCDataBufferImpl>(
+          webrtc::DataBuffer(data, binary)));
+}
+
+scoped_refptr<RTCDataBuffer> RTCDataBuffer::Create(const uint8_t* data,
+                                                   size_t size, bool binary) {
+  webrtc::CopyOnWriteBuffer copy(data, size);
+  return scoped_refptr<RTCDataBufferImpl>(
+      new RefCountedObject<RTCDataBufferImpl>(
+          webrtc::DataBuffer(copy, binary)));
+}
+
+RTCDataBufferImpl::RTCDataBufferImpl(const webrtc::DataBuffer& buffer)
+    : buffer_(buffer) {}
+
+const uint8_t* RTCDataBufferImpl::data() const { return buffer_.data.cdata(); }
+
+uint8_t* RTCDataBufferImpl::MutableData() {
+  return buffer_.data.MutableData();
+}
+
+size_t RTCDataBufferImpl::size() const { return buffer_.data.size(); }
+
+bool RTCDataBufferImpl::binary() const { return buffer_.binary; }
+
+}  // namespace libwebrtc
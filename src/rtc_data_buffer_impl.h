@@ -0,0 +1,33 @@
+#ifndef LIB_WEBRTC_RTC_DATA_BUFFER_IMPL_HXX
+#define LIB_WEBRTC_RTC_DATA_BUFFER_IMPL_HXX
+
+#include "api/data_channel_interface.h"
+#include "rtc_data_buffer.h"
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+class RTCDataBufferImpl : public RTCDataBuffer {
+ public:
+  RTCDataBufferImpl(const webrtc::DataBuffer& buffer);
+
+  virtual const uint8_t* data() const override;
+
+  virtual uint8_t* MutableData() override;
+
+  virtual size_t size() const override;
+
+  virtual bool binary() const override;
+
+  const webrtc::DataBuffer& data_buffer() const { return buffer_; }
+
+ protected:
+  virtual ~RTCDataBufferImpl() {}
+
+ private:
+  webrtc::DataBuffer buffer_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_DATA_BUFFER_IMPL_HXX
@@ -1,16 +1,48 @@
 #include "rtc_data_channel_impl.h"
 
+#include "api/sequence_checker.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_data_buffer_impl.h"
+
 namespace libwebrtc {
 
+// Payload the overflow list of a kBuffer channel may hold before incoming
+// messages are dropped.
+static const size_t kMaxOverflowBytes = 64 * 1024 * 1024;
+
 RTCDataChannelImpl::RTCDataChannelImpl(
-    webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel)
-    : rtc_data_channel_(rtc_data_channel), crit_sect_(new webrtc::Mutex()) {
+    webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel,
+    webrtc::Thread* network_thread,
+    std::function<void()> on_closed)
+    : rtc_data_channel_(rtc_data_channel),
+      network_thread_(network_thread),
+      on_closed_(std::move(on_closed)) {
   rtc_data_channel_->RegisterObserver(this);
   label_ = rtc_data_channel_->label();
 }
 
 RTCDataChannelImpl::~RTCDataChannelImpl() {
+  shutting_down_ = true;
+  // Returns once a native callback in progress has finished, none is
+  // delivered afterwards, so nothing posts to the delivery thread anymore.
   rtc_data_channel_->UnregisterObserver();
+  if (!delivery_thread_) return;
+  if (!delivery_thread_->IsCurrent()) {
+    // Waits for the task in progress, the queued ones are dropped.
+    delivery_thread_->BlockingCall(
+        [this] { delivery_safety_->SetNotAlive(); });
+    delivery_thread_->Stop();
+    return;
+  }
+  // The last reference was dropped by the observer from a delivery task,
+  // which checks the flag before touching the channel again. The thread
+  // cannot join itself: run no further tasks there and let the network
+  // thread join and destroy it once this task returns.
+  delivery_safety_->SetNotAlive();
+  delivery_thread_->Quit();
+  network_thread_->PostTask(
+      [thread = std::move(delivery_thread_)] { thread->Stop(); });
 }
 
 void RTCDataChannelImpl::Send(const uint8_t* data, uint32_t size,
@@ -20,20 +52,55 @@ void RTCDataChannelImpl::Send(const uint8_t* data, uint32_t size,
   rtc_data_channel_->Send(buffer);
 }
 
+void RTCDataChannelImpl::Send(scoped_refptr<RTCDataBuffer> buffer) {
+  if (!buffer) {
+    RTC_LOG(LS_WARNING) << "Ignoring null buffer on " << label_.std_string();
+    return;
+  }
+  RTCDataBufferImpl* impl = static_cast<RTCDataBufferImpl*>(buffer.get());
+  // DataBuffer shares the CopyOnWriteBuffer storage, no payload copy here.
+  rtc_data_channel_->Send(impl->data_buffer());
+}
+
+vector<bool> RTCDataChannelImpl::SendBatch(
+    const vector<scoped_refptr<RTCDataBuffer>> messages,
+    uint64_t& buffered_amount) {
+  std::vector<bool> results(messages.size(), false);
+  auto send_all = [&] {
+    // The data channel proxy dispatches Send() to the network thread and
+    // runs it inline when already there, so the whole batch is queued into
+    // SCTP with a single hop.
+    for (size_t i = 0; i < messages.size(); i++) {
+      RTCDataBufferImpl* impl =
+          static_cast<RTCDataBufferImpl*>(messages[i].get());
+      if (!impl) {
+        RTC_LOG(LS_WARNING) << "Ignoring null buffer " << i << " of batch on "
+                            << label_.std_string();
+        continue;
+      }
+      results[i] = rtc_data_channel_->Send(impl->data_buffer());
+    }
+    buffered_amount = rtc_data_channel_->buffered_amount();
+  };
+
+  if (network_thread_ && !network_thread_->IsCurrent()) {
+    network_thread_->BlockingCall(send_all);
+  } else {
+    send_all();
+  }
+  return results;
+}
+
 void RTCDataChannelImpl::Close() {
   rtc_data_channel_->UnregisterObserver();
   rtc_data_channel_->Close();
 }
 
 void RTCDataChannelImpl::RegisterObserver(RTCDataChannelObserver* observer) {
-  webrtc::MutexLock(crit_sect_.get());
   observer_ = observer;
 }
 
-void RTCDataChannelImpl::UnregisterObserver() {
-  webrtc::MutexLock(crit_sect_.get());
-  observer_ = nullptr;
-}
+void RTCDataChannelImpl::UnregisterObserver() { observer_ = nullptr; }
 
 const string RTCDataChannelImpl::label() const { return label_; }
 
@@ -41,6 +108,120 @@ int RTCDataChannelImpl::id() const { return rtc_data_channel_->id(); }
 
 uint64_t RTCDataChannelImpl::buffered_amount() const { return rtc_data_channel_->buffered_amount(); }
 
+void RTCDataChannelImpl::SetBufferedAmountLowThreshold(uint64_t threshold) {
+  bool low = false;
+  uint64_t amount = 0;
+  {
+    webrtc::MutexLock lock(&watermark_mutex_);
+    low = watermark_.SetThreshold(threshold);
+    amount = watermark_.amount();
+  }
+  if (!low) return;
+  PostToObserver([this, amount] {
+    RTCDataChannelObserver* observer = observer_;
+    if (observer) observer->OnBufferedAmountLow(amount);
+  });
+}
+
+uint64_t RTCDataChannelImpl::buffered_amount_low_threshold() const {
+  webrtc::MutexLock lock(&watermark_mutex_);
+  return watermark_.threshold();
+}
+
+void RTCDataChannelImpl::EnableDeliveryQueue(
+    uint32_t capacity, RTCDataChannelOverflowPolicy policy) {
+  if (delivery_enabled_ || polling_enabled_) return;
+  overflow_policy_ = policy;
+  delivery_queue_ = std::make_unique<BoundedQueue<PendingMessage>>(capacity);
+  delivery_thread_ = webrtc::Thread::Create();
+  delivery_thread_->SetName("dc_delivery_thread", nullptr);
+  RTC_CHECK(delivery_thread_->Start()) << "Failed to start thread";
+  delivery_safety_ = webrtc::PendingTaskSafetyFlag::CreateAttachedToTaskQueue(
+      true, delivery_thread_.get());
+  delivery_enabled_ = true;
+  // The native channel samples IsOkToCallOnTheNetworkThread() on
+  // registration, re-register so messages skip the signaling thread hop.
+  rtc_data_channel_->UnregisterObserver();
+  rtc_data_channel_->RegisterObserver(this);
+}
+
+void RTCDataChannelImpl::EnablePolling(uint32_t capacity,
+                                       RTCDataChannelOverflowPolicy policy) {
+  if (delivery_enabled_ || polling_enabled_) return;
+  overflow_policy_ = policy;
+  delivery_queue_ = std::make_unique<BoundedQueue<PendingMessage>>(capacity);
+  polling_enabled_ = true;
+  // Messages are queued directly on the network thread, see
+  // EnableDeliveryQueue().
+  rtc_data_channel_->UnregisterObserver();
+  rtc_data_channel_->RegisterObserver(this);
+}
+
+uint32_t RTCDataChannelImpl::Drain(uint32_t max_messages,
+                                   OnPolledMessage callback) {
+  if (!polling_enabled_) return 0;
+  uint32_t count = 0;
+  PendingMessage message;
+  while (count < max_messages && PopMessage(&message)) {
+    callback(message.buffer->data.cdata(), message.buffer->data.size(),
+             message.buffer->binary);
+    count++;
+  }
+  return count;
+}
+
+uint32_t RTCDataChannelImpl::Drain(scoped_refptr<RTCDataBuffer>* messages,
+                                   uint32_t max_messages) {
+  if (!polling_enabled_) return 0;
+  uint32_t count = 0;
+  PendingMessage message;
+  while (count < max_messages && PopMessage(&message)) {
+    messages[count++] = scoped_refptr<RTCDataBufferImpl>(
+        new RefCountedObject<RTCDataBufferImpl>(*message.buffer));
+  }
+  return count;
+}
+
+RTCDataChannelDeliveryStats RTCDataChannelImpl::delivery_stats() const {
+  RTCDataChannelDeliveryStats stats;
+  if (!delivery_enabled_ && !polling_enabled_) return stats;
+  stats.queue_depth = static_cast<uint32_t>(QueueDepth());
+  stats.max_queue_depth = max_queue_depth_;
+  stats.delivered_messages = delivered_messages_;
+  stats.dropped_messages = dropped_messages_;
+  stats.overflowed_messages = overflowed_messages_;
+  if (stats.delivered_messages > 0) {
+    stats.average_delivery_latency_us =
+        total_delivery_latency_us_ / stats.delivered_messages;
+  }
+  stats.max_delivery_latency_us = max_delivery_latency_us_;
+  return stats;
+}
+
+RTCDataChannelTrafficStats RTCDataChannelImpl::traffic_stats() const {
+  RTCDataChannelTrafficStats stats;
+  stats.messages_sent = rtc_data_channel_->messages_sent();
+  stats.bytes_sent = rtc_data_channel_->bytes_sent();
+  stats.messages_received = rtc_data_channel_->messages_received();
+  stats.bytes_received = rtc_data_channel_->bytes_received();
+  return stats;
+}
+
+bool RTCDataChannelImpl::IsOkToCallOnTheNetworkThread() {
+  return delivery_enabled_ || polling_enabled_;
+}
+
+void RTCDataChannelImpl::PostToObserver(
+    absl::AnyInvocable<void() &&> closure) {
+  if (shutting_down_) return;
+  if (delivery_enabled_) {
+    delivery_thread_->PostTask(
+        webrtc::SafeTask(delivery_safety_, std::move(closure)));
+  } else {
+    std::move(closure)();
+  }
+}
+
 void RTCDataChannelImpl::OnStateChange() {
   webrtc::DataChannelInterface::DataState state = rtc_data_channel_->state();
   switch (state) {
@@ -59,16 +240,128 @@ void RTCDataChannelImpl::OnStateChange() {
     default:
       break;
   }
-  webrtc::MutexLock(crit_sect_.get());
-  if (observer_) observer_->OnStateChange(state_);
+  RTCDataChannelState new_state = state_;
+  if (new_state == RTCDataChannelClosed && on_closed_) {
+    std::function<void()> on_closed = std::move(on_closed_);
+    on_closed_ = nullptr;
+    on_closed();
+  }
+  PostToObserver([this, new_state] {
+    RTCDataChannelObserver* observer = observer_;
+    if (observer) observer->OnStateChange(new_state);
+  });
 }
 
 RTCDataChannelState RTCDataChannelImpl::state() { return state_; }
 
 void RTCDataChannelImpl::OnMessage(const webrtc::DataBuffer& buffer) {
-  if (observer_)
-    observer_->OnMessage(buffer.data.data<char>(), buffer.data.size(),
-                         buffer.binary);
+  if (delivery_enabled_ || polling_enabled_) {
+    EnqueueMessage(buffer);
+    return;
+  }
+  DeliverMessage(buffer);
+}
+
+void RTCDataChannelImpl::DeliverMessage(const webrtc::DataBuffer& buffer) {
+  RTCDataChannelObserver* observer = observer_;
+  if (!observer) return;
+  if (observer->ReceivesMessageBuffers()) {
+    observer->OnMessageBuffer(scoped_refptr<RTCDataBufferImpl>(
+        new RefCountedObject<RTCDataBufferImpl>(buffer)));
+    return;
+  }
+  observer->OnMessage(buffer.data.data<char>(), buffer.data.size(),
+                      buffer.binary);
+}
+
+void RTCDataChannelImpl::EnqueueMessage(const webrtc::DataBuffer& buffer) {
+  if (shutting_down_) return;
+  PendingMessage message;
+  message.buffer.emplace(buffer);
+  message.enqueued_us = webrtc::TimeMicros();
+  if (overflow_size_ != 0 || !delivery_queue_->Push(std::move(message))) {
+    if (overflow_policy_ == RTCDataChannelOverflowPolicy::kDropNewest) {
+      dropped_messages_++;
+      return;
+    }
+    // Never wait here, the network thread is shared by every connection.
+    webrtc::MutexLock lock(&overflow_mutex_);
+    size_t size = message.buffer->size();
+    if (overflow_bytes_ + size > kMaxOverflowBytes) {
+      dropped_messages_++;
+      return;
+    }
+    overflow_bytes_ += size;
+    overflow_.push_back(std::move(message));
+    overflow_size_++;
+    overflowed_messages_++;
+  }
+
+  uint32_t depth = static_cast<uint32_t>(QueueDepth());
+  if (depth > max_queue_depth_) max_queue_depth_ = depth;
+
+  if (polling_enabled_) return;
+  if (!drain_scheduled_.exchange(true)) {
+    delivery_thread_->PostTask(webrtc::SafeTask(
+        delivery_safety_, [this] { DrainDeliveryQueue_d(); }));
+  }
+}
+
+void RTCDataChannelImpl::DrainDeliveryQueue_d() {
+  RTC_DCHECK_RUN_ON(delivery_thread_.get());
+  // The observer may drop the last reference while handling a message.
+  webrtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety =
+      delivery_safety_;
+  PendingMessage message;
+  while (true) {
+    while (PopMessage(&message)) {
+      DeliverMessage(*message.buffer);
+      if (!safety->alive()) return;
+    }
+    drain_scheduled_ = false;
+    // A message pushed after the last Pop() may have seen the flag still
+    // set and skipped scheduling, so check again before going idle.
+    if (QueueDepth() == 0 || drain_scheduled_.exchange(true)) return;
+  }
+}
+
+bool RTCDataChannelImpl::PopMessage(PendingMessage* message) {
+  if (!delivery_queue_->Pop(message)) {
+    // The producer only goes back to the queue once the overflow list is
+    // empty, so nothing in the queue is older than the list's front.
+    if (overflow_size_ == 0) return false;
+    webrtc::MutexLock lock(&overflow_mutex_);
+    if (overflow_.empty()) return false;
+    *message = std::move(overflow_.front());
+    overflow_.pop_front();
+    overflow_size_--;
+    overflow_bytes_ -= message->buffer->size();
+  }
+  int64_t latency_us = webrtc::TimeMicros() - message->enqueued_us;
+  total_delivery_latency_us_ += latency_us;
+  if (latency_us > max_delivery_latency_us_)
+    max_delivery_latency_us_ = latency_us;
+  delivered_messages_++;
+  return true;
+}
+
+size_t RTCDataChannelImpl::QueueDepth() const {
+  return delivery_queue_->size() + overflow_size_;
+}
+
+void RTCDataChannelImpl::OnBufferedAmountChange(uint64_t sent_data_size) {
+  uint64_t amount = rtc_data_channel_->buffered_amount();
+  bool low = false;
+  {
+    webrtc::MutexLock lock(&watermark_mutex_);
+    low = watermark_.Update(amount, sent_data_size);
+  }
+  PostToObserver([this, sent_data_size, amount, low] {
+    RTCDataChannelObserver* observer = observer_;
+    if (!observer) return;
+    observer->OnBufferedAmountChange(sent_data_size);
+    if (low) observer->OnBufferedAmountLow(amount);
+  });
 }
 
 }  // namespace libwebrtc
@@ -1,22 +1,42 @@
 #ifndef LIB_WEBRTC_RTC_DATA_CHANNEL_IMPL_HXX
 #define LIB_WEBRTC_RTC_DATA_CHANNEL_IMPL_HXX
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <optional>
+
+#include "absl/functional/any_invocable.h"
 #include "api/data_channel_interface.h"
+#include "api/task_queue/pending_task_safety_flag.h"
 #include "rtc_base/synchronization/mutex.h"
+#include "rtc_base/thread.h"
 #include "rtc_data_channel.h"
 #include "rtc_types.h"
+#include "src/internal/bounded_queue.h"
+#include "src/internal/buffered_amount_watermark.h"
 
 namespace libwebrtc {
 
 class RTCDataChannelImpl : public RTCDataChannel,
                            public webrtc::DataChannelObserver {
  public:
+  // |on_closed| runs once, on the thread reporting the state change, when
+  // the channel reaches RTCDataChannelClosed.
   RTCDataChannelImpl(
-      webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel);
+      webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel,
+      webrtc::Thread* network_thread,
+      std::function<void()> on_closed = nullptr);
 
   virtual void Send(const uint8_t* data, uint32_t size,
                     bool binary = false) override;
 
+  virtual void Send(scoped_refptr<RTCDataBuffer> buffer) override;
+
+  virtual vector<bool> SendBatch(
+      const vector<scoped_refptr<RTCDataBuffer>> messages,
+      uint64_t& buffered_amount) override;
+
   virtual void Close() override;
 
   virtual void RegisterObserver(RTCDataChannelObserver* observer) override;
@@ -29,6 +49,26 @@ class RTCDataChannelImpl : public RTCDataChannel,
 
   virtual uint64_t buffered_amount() const override;
 
+  virtual void SetBufferedAmountLowThreshold(uint64_t threshold) override;
+
+  virtual uint64_t buffered_amount_low_threshold() const override;
+
+  virtual void EnableDeliveryQueue(
+      uint32_t capacity, RTCDataChannelOverflowPolicy policy) override;
+
+  virtual RTCDataChannelDeliveryStats delivery_stats() const override;
+
+  virtual void EnablePolling(uint32_t capacity,
+                             RTCDataChannelOverflowPolicy policy) override;
+
+  virtual uint32_t Drain(uint32_t max_messages,
+                         OnPolledMessage callback) override;
+
+  virtual uint32_t Drain(scoped_refptr<RTCDataBuffer>* messages,
+                         uint32_t max_messages) override;
+
+  virtual RTCDataChannelTrafficStats traffic_stats() const override;
+
   virtual RTCDataChannelState state() override;
 
   webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel() {
@@ -42,12 +82,70 @@ class RTCDataChannelImpl : public RTCDataChannel,
 
   virtual void OnMessage(const webrtc::DataBuffer& buffer) override;
 
+  virtual void OnBufferedAmountChange(uint64_t sent_data_size) override;
+
+  virtual bool IsOkToCallOnTheNetworkThread() override;
+
+ private:
+  struct PendingMessage {
+    std::optional<webrtc::DataBuffer> buffer;
+    int64_t enqueued_us = 0;
+  };
+
+  void DeliverMessage(const webrtc::DataBuffer& buffer);
+
+  void EnqueueMessage(const webrtc::DataBuffer& buffer);
+
+  void DrainDeliveryQueue_d();
+
+  // Pops one message from the delivery queue, or from the overflow list once
+  // the queue is empty, and updates the delivery stats.
+  bool PopMessage(PendingMessage* message);
+
+  size_t QueueDepth() const;
+
+  // Runs |closure| on the delivery thread when the delivery queue is enabled,
+  // inline otherwise. Queued closures are dropped once the channel is
+  // destroyed.
+  void PostToObserver(absl::AnyInvocable<void() &&> closure);
+
  private:
   webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel_;
-  RTCDataChannelObserver* observer_ = nullptr;
-  std::unique_ptr<webrtc::Mutex> crit_sect_;
-  RTCDataChannelState state_;
+  webrtc::Thread* network_thread_ = nullptr;
+  std::function<void()> on_closed_;
+  std::atomic<RTCDataChannelObserver*> observer_{nullptr};
+  RTCDataChannelState state_ = RTCDataChannelConnecting;
+  mutable webrtc::Mutex watermark_mutex_;
+  BufferedAmountWatermark watermark_;
   string label_;
+
+  std::unique_ptr<webrtc::Thread> delivery_thread_;
+  // Delivery tasks hold |this| without a reference: native callbacks may
+  // post while the last reference is being dropped, and taking one then
+  // would revive the channel. Cleared on the delivery thread when the
+  // channel is destroyed.
+  webrtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> delivery_safety_;
+  std::unique_ptr<BoundedQueue<PendingMessage>> delivery_queue_;
+  std::atomic<bool> delivery_enabled_{false};
+  std::atomic<bool> polling_enabled_{false};
+  std::atomic<bool> drain_scheduled_{false};
+  // Set first thing in the destructor, no new messages or tasks after that.
+  std::atomic<bool> shutting_down_{false};
+  RTCDataChannelOverflowPolicy overflow_policy_ =
+      RTCDataChannelOverflowPolicy::kBuffer;
+  // Messages that did not fit in |delivery_queue_|. While it is not empty,
+  // new messages are appended here too so the order is kept.
+  webrtc::Mutex overflow_mutex_;
+  std::deque<PendingMessage> overflow_;
+  // Payload bytes in |overflow_|, guarded by |overflow_mutex_|.
+  size_t overflow_bytes_ = 0;
+  std::atomic<size_t> overflow_size_{0};
+  std::atomic<uint64_t> overflowed_messages_{0};
+  std::atomic<uint32_t> max_queue_depth_{0};
+  std::atomic<uint64_t> delivered_messages_{0};
+  std::atomic<uint64_t> dropped_messages_{0};
+  std::atomic<int64_t> total_delivery_latency_us_{0};
+  std::atomic<int64_t> max_delivery_latency_us_{0};
 };
 
 }  // namespace libwebrtc
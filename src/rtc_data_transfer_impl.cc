@@ -0,0 +1,499 @@
+#include "rtc_data_transfer_impl.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "rtc_base/logging.h"
+#include "rtc_data_buffer.h"
+#include "src/internal/data_transfer_framing.h"
+
+namespace libwebrtc {
+
+namespace {
+
+int SeekFile(FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+  return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+class FileSink : public RTCDataTransferSink {
+ public:
+  explicit FileSink(FILE* file) : file_(file) {}
+
+  bool Write(uint64_t offset, const uint8_t* data, size_t size) override {
+    if (offset != position_) {
+      if (SeekFile(file_, offset) != 0) return false;
+      position_ = offset;
+    }
+    if (fwrite(data, 1, size, file_) != size) return false;
+    position_ += size;
+    return true;
+  }
+
+  void Close(bool success) override {
+    fclose(file_);
+    delete this;
+  }
+
+ private:
+  ~FileSink() override {}
+
+  FILE* file_;
+  uint64_t position_ = 0;
+};
+
+}  // namespace
+
+scoped_refptr<RTCDataTransfer> RTCDataTransfer::Create(
+    scoped_refptr<RTCDataChannel> data_channel,
+    RTCDataTransferObserver* observer, const RTCDataTransferOptions& options) {
+  return scoped_refptr<RTCDataTransfer>(
+      new RefCountedObject<RTCDataTransferImpl>(data_channel, observer,
+                                                options));
+}
+
+RTCDataTransferSink* RTCDataTransfer::CreateFileSink(const string path) {
+  FILE* file = fopen(path.c_string(), "wb");
+  if (!file) {
+    RTC_LOG(LS_ERROR) << "Failed to open " << path.std_string();
+    return nullptr;
+  }
+  return new FileSink(file);
+}
+
+RTCDataTransferImpl::RTCDataTransferImpl(
+    scoped_refptr<RTCDataChannel> data_channel,
+    RTCDataTransferObserver* observer, const RTCDataTransferOptions& options)
+    : data_channel_(data_channel), observer_(observer), options_(options) {
+  options_.chunk_size = std::max<uint32_t>(options_.chunk_size, 1);
+  options_.window_size =
+      std::max<uint64_t>(options_.window_size, options_.chunk_size);
+  data_channel_->SetBufferedAmountLowThreshold(options_.window_size / 2);
+  data_channel_->RegisterObserver(this);
+}
+
+RTCDataTransferImpl::~RTCDataTransferImpl() { Close(); }
+
+uint32_t RTCDataTransferImpl::SendFile(const string path, const string name) {
+  FILE* file = fopen(path.c_string(), "rb");
+  if (!file) {
+    RTC_LOG(LS_ERROR) << "Failed to open " << path.std_string();
+    return 0;
+  }
+  std::unique_ptr<OutgoingTransfer> transfer(new OutgoingTransfer());
+  if (fseek(file, 0, SEEK_END) == 0) {
+#if defined(_WIN32)
+    __int64 size = _ftelli64(file);
+#else
+    off_t size = ftello(file);
+#endif
+    transfer->size = size > 0 ? static_cast<uint64_t>(size) : 0;
+  }
+  rewind(file);
+  transfer->file = file;
+  transfer->name = name.std_string();
+  return Enqueue(std::move(transfer));
+}
+
+uint32_t RTCDataTransferImpl::SendData(const uint8_t* data, uint64_t size,
+                                       const string name) {
+  std::unique_ptr<OutgoingTransfer> transfer(new OutgoingTransfer());
+  transfer->data = data;
+  transfer->size = size;
+  transfer->name = name.std_string();
+  return Enqueue(std::move(transfer));
+}
+
+uint32_t RTCDataTransferImpl::Enqueue(
+    std::unique_ptr<OutgoingTransfer> transfer) {
+  uint32_t id;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (closed_) {
+      if (transfer->file) fclose(transfer->file);
+      return 0;
+    }
+    id = next_transfer_id_++;
+    if (next_transfer_id_ & kIncomingTransferIdBit) next_transfer_id_ = 1;
+    transfer->id = id;
+    outgoing_.push_back(std::move(transfer));
+  }
+  Pump();
+  return id;
+}
+
+scoped_refptr<RTCDataBuffer> RTCDataTransferImpl::ControlMessage(
+    uint8_t kind, uint32_t transfer_id, const uint8_t* extra,
+    size_t extra_size) {
+  scoped_refptr<RTCDataBuffer> buffer =
+      RTCDataBuffer::Create(kTransferControlHeaderSize + extra_size);
+  uint8_t* out = buffer->MutableData();
+  out[0] = kind;
+  WriteTransferUint32(out + 1, transfer_id);
+  if (extra_size > 0)
+    memcpy(out + kTransferControlHeaderSize, extra, extra_size);
+  return buffer;
+}
+
+bool RTCDataTransferImpl::SendControl(uint8_t kind, uint32_t transfer_id,
+                                      const uint8_t* extra,
+                                      size_t extra_size) {
+  if (data_channel_->state() != RTCDataChannelOpen) return false;
+  data_channel_->Send(ControlMessage(kind, transfer_id, extra, extra_size));
+  return true;
+}
+
+void RTCDataTransferImpl::Pump() {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    // Pump() runs from the caller's thread and from observer callbacks. Only
+    // one of them drives the queue so chunks go out in order, the others
+    // must not wait for it: the pumping thread may be blocked on a send to
+    // the network thread that is delivering their callback.
+    if (pumping_) {
+      pump_again_ = true;
+      return;
+    }
+    pumping_ = true;
+  }
+
+  while (true) {
+    bool open = data_channel_->state() == RTCDataChannelOpen;
+    uint64_t buffered_amount = open ? data_channel_->buffered_amount() : 0;
+    std::vector<scoped_refptr<RTCDataBuffer>> batch;
+    std::vector<std::function<void()>> notifications;
+    bool again = false;
+    {
+      webrtc::MutexLock lock(&mutex_);
+      if (open && !closed_)
+        FillBatch_l(buffered_amount, &batch, &notifications);
+      again = !batch.empty() || pump_again_;
+      pump_again_ = false;
+      if (!again) pumping_ = false;
+    }
+
+    if (!batch.empty()) {
+      // One hop to the network thread for the whole window.
+      vector<bool> sent =
+          data_channel_->SendBatch(vector<scoped_refptr<RTCDataBuffer>>(batch),
+                                   buffered_amount);
+      for (size_t i = 0; i < sent.size(); i++) {
+        if (sent[i]) continue;
+        RTC_LOG(LS_ERROR) << "Failed to send transfer message on "
+                          << data_channel_->label().std_string();
+        break;
+      }
+    }
+
+    if (observer_) {
+      for (auto& notification : notifications) notification();
+    }
+    if (!again) return;
+  }
+}
+
+void RTCDataTransferImpl::FillBatch_l(
+    uint64_t buffered_amount,
+    std::vector<scoped_refptr<RTCDataBuffer>>* batch,
+    std::vector<std::function<void()>>* notifications) {
+  uint64_t queued = buffered_amount;
+  while (!outgoing_.empty() && queued < options_.window_size) {
+    OutgoingTransfer* transfer = outgoing_.front().get();
+    uint32_t id = transfer->id;
+
+    if (!transfer->begin_sent) {
+      std::vector<uint8_t> extra(8 + transfer->name.size());
+      WriteTransferUint64(extra.data(), transfer->size);
+      memcpy(extra.data() + 8, transfer->name.data(), transfer->name.size());
+      batch->push_back(
+          ControlMessage(kTransferBegin, id, extra.data(), extra.size()));
+      queued += batch->back()->size();
+      transfer->begin_sent = true;
+    }
+
+    if (transfer->offset == transfer->size) {
+      batch->push_back(ControlMessage(kTransferEnd, id, nullptr, 0));
+      queued += batch->back()->size();
+      uint64_t size = transfer->size;
+      PopOutgoing();
+      notifications->push_back([this, id, size] {
+        observer_->OnProgress(id, false, size, size);
+        observer_->OnComplete(id, false, true);
+      });
+      continue;
+    }
+
+    size_t length = static_cast<size_t>(std::min<uint64_t>(
+        options_.chunk_size, transfer->size - transfer->offset));
+    scoped_refptr<RTCDataBuffer> buffer =
+        RTCDataBuffer::Create(kTransferChunkHeaderSize + length);
+    uint8_t* out = buffer->MutableData();
+    out[0] = kTransferChunk;
+    WriteTransferUint32(out + 1, id);
+    WriteTransferUint64(out + kTransferControlHeaderSize, transfer->offset);
+    bool ok = true;
+    if (transfer->file) {
+      // Read straight into the outgoing message, no staging copy.
+      ok = fread(out + kTransferChunkHeaderSize, 1, length, transfer->file) ==
+           length;
+    } else {
+      memcpy(out + kTransferChunkHeaderSize, transfer->data + transfer->offset,
+             length);
+    }
+    if (!ok) {
+      RTC_LOG(LS_ERROR) << "Failed to read transfer " << id;
+      batch->push_back(ControlMessage(kTransferAbort, id, nullptr, 0));
+      queued += batch->back()->size();
+      PopOutgoing();
+      notifications->push_back(
+          [this, id] { observer_->OnComplete(id, false, false); });
+      continue;
+    }
+    batch->push_back(buffer);
+    queued += buffer->size();
+    transfer->offset += length;
+
+    if (transfer->offset - transfer->last_progress >=
+            options_.progress_interval &&
+        transfer->offset < transfer->size) {
+      uint64_t offset = transfer->offset;
+      uint64_t size = transfer->size;
+      transfer->last_progress = offset;
+      notifications->push_back([this, id, offset, size] {
+        observer_->OnProgress(id, false, offset, size);
+      });
+    }
+  }
+}
+
+void RTCDataTransferImpl::PopOutgoing() {
+  std::unique_ptr<OutgoingTransfer> transfer = std::move(outgoing_.front());
+  outgoing_.pop_front();
+  if (transfer->file) fclose(transfer->file);
+}
+
+void RTCDataTransferImpl::CloseSink(IncomingTransfer* transfer,
+                                    bool success) {
+  webrtc::MutexLock lock(&transfer->sink_mutex);
+  if (!transfer->sink) return;
+  transfer->sink->Close(success);
+  transfer->sink = nullptr;
+}
+
+void RTCDataTransferImpl::FinishIncoming(uint32_t transfer_id, bool success) {
+  std::shared_ptr<IncomingTransfer> transfer;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    auto it = incoming_.find(transfer_id);
+    if (it == incoming_.end()) return;
+    transfer = it->second;
+    incoming_.erase(it);
+  }
+  CloseSink(transfer.get(), success);
+  if (observer_) observer_->OnComplete(transfer_id, true, success);
+}
+
+void RTCDataTransferImpl::RejectIncoming(uint32_t transfer_id) {
+  SendControl(kTransferReject, transfer_id & ~kIncomingTransferIdBit, nullptr,
+              0);
+  FinishIncoming(transfer_id, false);
+}
+
+void RTCDataTransferImpl::Cancel(uint32_t transfer_id) {
+  if (transfer_id & kIncomingTransferIdBit) {
+    RejectIncoming(transfer_id);
+    return;
+  }
+
+  bool cancelled = false;
+  bool begin_sent = false;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    for (auto it = outgoing_.begin(); it != outgoing_.end(); ++it) {
+      if ((*it)->id != transfer_id) continue;
+      begin_sent = (*it)->begin_sent;
+      if ((*it)->file) fclose((*it)->file);
+      outgoing_.erase(it);
+      cancelled = true;
+      break;
+    }
+  }
+  if (!cancelled) return;
+  // Chunks of a batch still being sent may follow the abort, the receiver
+  // drops them once the transfer is gone.
+  if (begin_sent) SendControl(kTransferAbort, transfer_id, nullptr, 0);
+  if (observer_) observer_->OnComplete(transfer_id, false, false);
+  Pump();
+}
+
+void RTCDataTransferImpl::Close() {
+  std::map<uint32_t, std::shared_ptr<IncomingTransfer>> incoming;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (closed_) return;
+    closed_ = true;
+    for (auto& transfer : outgoing_) {
+      if (transfer->file) fclose(transfer->file);
+    }
+    outgoing_.clear();
+    incoming.swap(incoming_);
+  }
+  data_channel_->UnregisterObserver();
+  for (auto& it : incoming) CloseSink(it.second.get(), false);
+}
+
+void RTCDataTransferImpl::OnStateChange(RTCDataChannelState state) {
+  if (state == RTCDataChannelOpen) {
+    Pump();
+  } else if (state == RTCDataChannelClosed) {
+    Close();
+  }
+}
+
+void RTCDataTransferImpl::OnBufferedAmountChange(uint64_t sent_data_size) {
+  // Fallback for a missed low event, Pump() returns right away while the
+  // window is still full.
+  Pump();
+}
+
+void RTCDataTransferImpl::OnBufferedAmountLow(uint64_t buffered_amount) {
+  Pump();
+}
+
+void RTCDataTransferImpl::OnMessage(const char* buffer, int length,
+                                    bool binary) {
+  TransferFrame frame;
+  if (!binary ||
+      !ParseTransferFrame(reinterpret_cast<const uint8_t*>(buffer),
+                          static_cast<size_t>(length), &frame) ||
+      (frame.id & kIncomingTransferIdBit)) {
+    RTC_LOG(LS_WARNING) << "Ignoring non-transfer message on "
+                        << data_channel_->label().std_string();
+    return;
+  }
+  // Frames about the peer's transfers carry the peer's id, tag it so it
+  // can't collide with the ids of our own transfers.
+  uint32_t id = frame.id | kIncomingTransferIdBit;
+
+  switch (frame.kind) {
+    case kTransferBegin: {
+      uint64_t total = frame.value;
+      std::string name(reinterpret_cast<const char*>(frame.payload),
+                       frame.payload_size);
+      RTCDataTransferSink* sink =
+          observer_ ? observer_->OnIncomingTransfer(id, string(name), total)
+                    : nullptr;
+      if (!sink) {
+        SendControl(kTransferReject, frame.id, nullptr, 0);
+        return;
+      }
+      webrtc::MutexLock lock(&mutex_);
+      if (closed_ || incoming_.find(id) != incoming_.end()) {
+        RTC_LOG(LS_WARNING) << "Dropping begin of transfer " << id;
+        sink->Close(false);
+        return;
+      }
+      std::shared_ptr<IncomingTransfer> transfer =
+          std::make_shared<IncomingTransfer>();
+      transfer->sink = sink;
+      transfer->size = total;
+      incoming_[id] = transfer;
+      break;
+    }
+    case kTransferChunk: {
+      uint64_t offset = frame.value;
+      size_t payload = frame.payload_size;
+      std::shared_ptr<IncomingTransfer> transfer;
+      {
+        webrtc::MutexLock lock(&mutex_);
+        auto it = incoming_.find(id);
+        if (it == incoming_.end()) return;
+        transfer = it->second;
+      }
+      if (!TransferChunkFits(offset, payload, transfer->size)) {
+        RTC_LOG(LS_ERROR) << "Chunk at " << offset << " of " << payload
+                          << " bytes exceeds transfer " << id << " of "
+                          << transfer->size << " bytes";
+        RejectIncoming(id);
+        return;
+      }
+      bool written = false;
+      {
+        // Holding the sink lock keeps a concurrent Cancel() or Close() from
+        // closing, and possibly deleting, the sink during the write.
+        webrtc::MutexLock lock(&transfer->sink_mutex);
+        if (!transfer->sink) return;
+        written = transfer->sink->Write(offset, frame.payload, payload);
+      }
+      if (!written) {
+        RTC_LOG(LS_ERROR) << "Sink rejected chunk of transfer " << id;
+        RejectIncoming(id);
+        return;
+      }
+      uint64_t received = 0;
+      uint64_t total = transfer->size;
+      bool report = false;
+      {
+        webrtc::MutexLock lock(&mutex_);
+        transfer->received += payload;
+        received = transfer->received;
+        if (received - transfer->last_progress >= options_.progress_interval &&
+            received < total) {
+          transfer->last_progress = received;
+          report = true;
+        }
+      }
+      if (report && observer_) observer_->OnProgress(id, true, received, total);
+      break;
+    }
+    case kTransferEnd: {
+      uint64_t received = 0;
+      uint64_t total = 0;
+      {
+        webrtc::MutexLock lock(&mutex_);
+        auto it = incoming_.find(id);
+        if (it == incoming_.end()) return;
+        received = it->second->received;
+        total = it->second->size;
+      }
+      bool success = received == total;
+      if (success && observer_) observer_->OnProgress(id, true, total, total);
+      FinishIncoming(id, success);
+      break;
+    }
+    case kTransferAbort:
+      FinishIncoming(id, false);
+      break;
+    case kTransferReject: {
+      // Refers to one of our outgoing transfers, by our own id.
+      id = frame.id;
+      bool rejected = false;
+      {
+        webrtc::MutexLock lock(&mutex_);
+        for (auto it = outgoing_.begin(); it != outgoing_.end(); ++it) {
+          if ((*it)->id != id) continue;
+          if ((*it)->file) fclose((*it)->file);
+          outgoing_.erase(it);
+          rejected = true;
+          break;
+        }
+      }
+      if (rejected) {
+        if (observer_) observer_->OnComplete(id, false, false);
+        Pump();
+      }
+      break;
+    }
+    default:
+      RTC_LOG(LS_WARNING) << "Unknown transfer frame " << int(frame.kind);
+      break;
+  }
+}
+
+}  // namespace libwebrtc
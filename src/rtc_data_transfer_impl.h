@@ -0,0 +1,116 @@
+#ifndef LIB_WEBRTC_RTC_DATA_TRANSFER_IMPL_HXX
+#define LIB_WEBRTC_RTC_DATA_TRANSFER_IMPL_HXX
+
+#include <stdio.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_data_buffer.h"
+#include "rtc_data_transfer.h"
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+class RTCDataTransferImpl : public RTCDataTransfer,
+                            public RTCDataChannelObserver {
+ public:
+  RTCDataTransferImpl(scoped_refptr<RTCDataChannel> data_channel,
+                      RTCDataTransferObserver* observer,
+                      const RTCDataTransferOptions& options);
+
+  virtual uint32_t SendFile(const string path, const string name) override;
+
+  virtual uint32_t SendData(const uint8_t* data, uint64_t size,
+                            const string name) override;
+
+  virtual void Cancel(uint32_t transfer_id) override;
+
+  virtual void Close() override;
+
+ protected:
+  virtual ~RTCDataTransferImpl();
+
+  virtual void OnStateChange(RTCDataChannelState state) override;
+
+  virtual void OnMessage(const char* buffer, int length, bool binary) override;
+
+  virtual void OnBufferedAmountChange(uint64_t sent_data_size) override;
+
+  virtual void OnBufferedAmountLow(uint64_t buffered_amount) override;
+
+ private:
+  struct OutgoingTransfer {
+    uint32_t id = 0;
+    std::string name;
+    uint64_t size = 0;
+    uint64_t offset = 0;
+    uint64_t last_progress = 0;
+    bool begin_sent = false;
+    FILE* file = nullptr;
+    const uint8_t* data = nullptr;
+  };
+
+  struct IncomingTransfer {
+    // Serializes Write() and Close() on the sink. |sink| is reset once it
+    // has been closed.
+    webrtc::Mutex sink_mutex;
+    RTCDataTransferSink* sink = nullptr;
+    uint64_t size = 0;
+    // Guarded by |mutex_|.
+    uint64_t received = 0;
+    uint64_t last_progress = 0;
+  };
+
+  uint32_t Enqueue(std::unique_ptr<OutgoingTransfer> transfer);
+
+  // Sends chunks until the window is full or the queue is empty. One thread
+  // pumps at a time; the data channel, whose calls hop to the network
+  // thread, is never called with |mutex_| held.
+  void Pump();
+
+  // Moves the messages that fit in the window, given the channel's
+  // |buffered_amount|, from the queue into |batch|.
+  void FillBatch_l(uint64_t buffered_amount,
+                   std::vector<scoped_refptr<RTCDataBuffer>>* batch,
+                   std::vector<std::function<void()>>* notifications);
+
+  static scoped_refptr<RTCDataBuffer> ControlMessage(uint8_t kind,
+                                                     uint32_t transfer_id,
+                                                     const uint8_t* extra,
+                                                     size_t extra_size);
+
+  bool SendControl(uint8_t kind, uint32_t transfer_id, const uint8_t* extra,
+                   size_t extra_size);
+
+  void PopOutgoing();
+
+  void FinishIncoming(uint32_t transfer_id, bool success);
+
+  // Tells the sender to stop and fails the incoming transfer.
+  void RejectIncoming(uint32_t transfer_id);
+
+  static void CloseSink(IncomingTransfer* transfer, bool success);
+
+ private:
+  scoped_refptr<RTCDataChannel> data_channel_;
+  RTCDataTransferObserver* observer_ = nullptr;
+  RTCDataTransferOptions options_;
+  webrtc::Mutex mutex_;
+  uint32_t next_transfer_id_ = 1;
+  bool closed_ = false;
+  // Set while a thread runs Pump(). Callers finding it set raise
+  // |pump_again_| and return, the pumping thread then goes round again.
+  bool pumping_ = false;
+  bool pump_again_ = false;
+  std::deque<std::unique_ptr<OutgoingTransfer>> outgoing_;
+  std::map<uint32_t, std::shared_ptr<IncomingTransfer>> incoming_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_DATA_TRANSFER_IMPL_HXX
@@ -29,14 +29,18 @@ enum { kCaptureDelay = 33, kCaptureMessageId = 1000 };
 
 RTCDesktopCapturerImpl::RTCDesktopCapturerImpl(
     DesktopType type, webrtc::DesktopCapturer::SourceId source_id,
-    webrtc::Thread* signaling_thread, scoped_refptr<MediaSource> source)
+    webrtc::Thread* signaling_thread, scoped_refptr<MediaSource> source,
+    const RTCThreadOptions& thread_options)
     : thread_(webrtc::Thread::Create()),
       source_id_(source_id),
       signaling_thread_(signaling_thread),
       source_(source) {
   RTC_DCHECK(thread_);
   type_ = type;
+  thread_->SetName(ThreadName(thread_options, "desktop_capture_thread"),
+                   nullptr);
   thread_->Start();
+  ApplyThreadOptions(thread_.get(), thread_options);
   options_ = webrtc::DesktopCaptureOptions::CreateDefault();
   options_.set_detect_updated_region(true);
 #ifdef WEBRTC_WIN
@@ -20,12 +20,14 @@
 #include "api/video/i420_buffer.h"
 #include "api/video/video_frame.h"
 #include "include/rtc_desktop_capturer.h"
+#include "include/rtc_peerconnection_factory.h"
 #include "include/rtc_types.h"
 #include "modules/desktop_capture/desktop_and_cursor_composer.h"
 #include "modules/desktop_capture/desktop_capture_options.h"
 #include "modules/desktop_capture/desktop_capturer.h"
 #include "modules/desktop_capture/desktop_frame.h"
 #include "rtc_base/thread.h"
+#include "src/internal/thread_options.h"
 #include "src/internal/vcm_capturer.h"
 #include "src/internal/video_capturer.h"
 
@@ -38,7 +40,9 @@ class RTCDesktopCapturerImpl : public RTCDesktopCapturer,
   RTCDesktopCapturerImpl(DesktopType type,
                          webrtc::DesktopCapturer::SourceId source_id,
                          webrtc::Thread* signaling_thread,
-                         scoped_refptr<MediaSource> source);
+                         scoped_refptr<MediaSource> source,
+                         const RTCThreadOptions& thread_options =
+                             RTCThreadOptions());
   ~RTCDesktopCapturerImpl();
 
   void RegisterDesktopCapturerObserver(
@@ -7,8 +7,11 @@
 
 namespace libwebrtc {
 
-RTCDesktopDeviceImpl::RTCDesktopDeviceImpl(webrtc::Thread* signaling_thread)
-    : signaling_thread_(signaling_thread) {}
+RTCDesktopDeviceImpl::RTCDesktopDeviceImpl(
+    webrtc::Thread* signaling_thread,
+    const RTCThreadOptions& capture_thread_options)
+    : signaling_thread_(signaling_thread),
+      capture_thread_options_(capture_thread_options) {}
 
 RTCDesktopDeviceImpl::~RTCDesktopDeviceImpl() {}
 
@@ -16,7 +19,8 @@ scoped_refptr<RTCDesktopCapturer> RTCDesktopDeviceImpl::CreateDesktopCapturer(
     scoped_refptr<MediaSource> source) {
   MediaSourceImpl* source_impl = static_cast<MediaSourceImpl*>(source.get());
   return new RefCountedObject<RTCDesktopCapturerImpl>(
-      source_impl->type(), source_impl->source_id(), signaling_thread_, source);
+      source_impl->type(), source_impl->source_id(), signaling_thread_, source,
+      capture_thread_options_);
 }
 
 scoped_refptr<RTCDesktopMediaList> RTCDesktopDeviceImpl::GetDesktopMediaList(
@@ -11,12 +11,14 @@
 #include "rtc_base/thread.h"
 #include "rtc_desktop_device.h"
 #include "rtc_desktop_media_list_impl.h"
+#include "rtc_peerconnection_factory.h"
 
 namespace libwebrtc {
 
 class RTCDesktopDeviceImpl : public RTCDesktopDevice {
  public:
-  RTCDesktopDeviceImpl(webrtc::Thread* signaling_thread);
+  RTCDesktopDeviceImpl(webrtc::Thread* signaling_thread,
+                       const RTCThreadOptions& capture_thread_options);
   ~RTCDesktopDeviceImpl();
 
   scoped_refptr<RTCDesktopCapturer> CreateDesktopCapturer(
@@ -27,6 +29,7 @@ class RTCDesktopDeviceImpl : public RTCDesktopDevice {
 
  private:
   webrtc::Thread* signaling_thread_ = nullptr;
+  RTCThreadOptions capture_thread_options_;
   std::map<DesktopType, scoped_refptr<RTCDesktopMediaListImpl>>
       desktop_media_lists_;
 };
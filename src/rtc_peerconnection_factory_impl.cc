@@ -1,19 +1,35 @@
 #include "rtc_peerconnection_factory_impl.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+
+#include "api/audio/audio_processing.h"
+#include "api/audio/builtin_audio_processing_builder.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
 #include "api/audio_codecs/builtin_audio_encoder_factory.h"
-#include "api/create_peerconnection_factory.h"
+#include "api/enable_media.h"
+#include "api/environment/environment_factory.h"
 #include "api/media_stream_interface.h"
+#include "api/rtc_event_log/rtc_event_log_factory.h"
+#include "api/units/time_delta.h"
 #include "api/video_codecs/builtin_video_decoder_factory.h"
 #include "api/video_codecs/builtin_video_encoder_factory.h"
 #include "modules/audio_device/audio_device_impl.h"
 #include "rtc_audio_source_impl.h"
+#include "rtc_base/rtc_certificate_generator.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_media_stream_impl.h"
 #include "rtc_mediaconstraints_impl.h"
 #include "rtc_peerconnection_impl.h"
 #include "rtc_rtp_capabilities_impl.h"
 #include "rtc_video_device_impl.h"
 #include "rtc_video_source_impl.h"
+#include "src/internal/constraint_list.h"
+#include "src/internal/sctp_transport_factory.h"
+#include "src/internal/socket_options.h"
 #if defined(USE_INTEL_MEDIA_SDK)
 #include "src/win/mediacapabilities.h"
 #include "src/win/msdkvideodecoderfactory.h"
@@ -42,27 +58,120 @@ std::unique_ptr<webrtc::VideoDecoderFactory> CreateIntelVideoDecoderFactory() {
 }
 #endif
 
-RTCPeerConnectionFactoryImpl::RTCPeerConnectionFactoryImpl() {}
+static bool SameConstraints(scoped_refptr<RTCMediaConstraints> a,
+                            scoped_refptr<RTCMediaConstraints> b) {
+  RTCMediaConstraintsImpl* impl_a =
+      static_cast<RTCMediaConstraintsImpl*>(a.get());
+  RTCMediaConstraintsImpl* impl_b =
+      static_cast<RTCMediaConstraintsImpl*>(b.get());
+  return SameConstraintList(impl_a ? &impl_a->GetMandatory() : nullptr,
+                            impl_b ? &impl_b->GetMandatory() : nullptr) &&
+         SameConstraintList(impl_a ? &impl_a->GetOptional() : nullptr,
+                            impl_b ? &impl_b->GetOptional() : nullptr);
+}
+
+RTCPeerConnectionFactoryImpl::RTCPeerConnectionFactoryImpl(
+    const RTCPeerConnectionFactoryOptions& options)
+    : options_(options) {}
+
+// Signaling threads of factories destroyed from one of their own tasks.
+// They have quit but can't join themselves; the next factory destroyed
+// elsewhere, or LibWebRTC::Terminate(), joins them.
+static webrtc::Mutex& RetiredThreadsMutex() {
+  static webrtc::Mutex* mutex = new webrtc::Mutex();
+  return *mutex;
+}
+
+static std::vector<std::unique_ptr<webrtc::Thread>>& RetiredThreads() {
+  static std::vector<std::unique_ptr<webrtc::Thread>>* threads =
+      new std::vector<std::unique_ptr<webrtc::Thread>>();
+  return *threads;
+}
+
+void RTCPeerConnectionFactoryImpl::JoinRetiredThreads() {
+  std::vector<std::unique_ptr<webrtc::Thread>> threads;
+  {
+    webrtc::MutexLock lock(&RetiredThreadsMutex());
+    threads.swap(RetiredThreads());
+  }
+  for (auto& thread : threads) thread->Stop();
+}
+
+RTCPeerConnectionFactoryImpl::~RTCPeerConnectionFactoryImpl() {
+  // Pool tasks on the signaling thread use the members destroyed after this
+  // body. Wait for a running one and drop the queued ones first.
+  if (!signaling_thread_) return;
+  if (!signaling_thread_->IsCurrent()) {
+    signaling_thread_->Stop();
+    JoinRetiredThreads();
+    return;
+  }
+  // The last reference was dropped by a task on the signaling thread, so no
+  // other task runs meanwhile. The thread can't join itself: quit it and
+  // leave it to be joined once this task has returned.
+  signaling_thread_->Quit();
+  webrtc::MutexLock lock(&RetiredThreadsMutex());
+  RetiredThreads().push_back(std::move(signaling_thread_));
+}
 
-RTCPeerConnectionFactoryImpl::~RTCPeerConnectionFactoryImpl() {}
+// Writing the environment races with getenv() on other threads, so it only
+// happens once, before the first factory starts its threads.
+static void InstallAudioTargetBuffer(uint32_t target_buffer_ms) {
+#if defined(WEBRTC_LINUX)
+  static std::once_flag once;
+  std::call_once(once, [target_buffer_ms] {
+    if (target_buffer_ms == 0 || getenv("PULSE_LATENCY_MSEC")) return;
+    setenv("PULSE_LATENCY_MSEC", std::to_string(target_buffer_ms).c_str(), 0);
+  });
+#endif
+}
 
 bool RTCPeerConnectionFactoryImpl::Initialize() {
+  InstallAudioTargetBuffer(options_.audio_target_buffer_ms);
+
   worker_thread_ = webrtc::Thread::Create();
-  worker_thread_->SetName("worker_thread", nullptr);
+  worker_thread_->SetName(ThreadName(options_.worker_thread, "worker_thread"),
+                          nullptr);
   RTC_CHECK(worker_thread_->Start()) << "Failed to start thread";
+  bool threads_applied =
+      ApplyThreadOptions(worker_thread_.get(), options_.worker_thread);
 
   signaling_thread_ = webrtc::Thread::Create();
-  signaling_thread_->SetName("signaling_thread", nullptr);
+  signaling_thread_->SetName(
+      ThreadName(options_.signaling_thread, "signaling_thread"), nullptr);
   RTC_CHECK(signaling_thread_->Start()) << "Failed to start thread";
+  threads_applied &=
+      ApplyThreadOptions(signaling_thread_.get(), options_.signaling_thread);
 
   network_thread_ = webrtc::Thread::CreateWithSocketServer();
-  network_thread_->SetName("network_thread", nullptr);
+  network_thread_->SetName(
+      ThreadName(options_.network_thread, "network_thread"), nullptr);
   RTC_CHECK(network_thread_->Start()) << "Failed to start thread";
+  threads_applied &=
+      ApplyThreadOptions(network_thread_.get(), options_.network_thread);
+  if (options_.shared_udp_port > 0) {
+    network_thread_->BlockingCall([this] {
+      shared_udp_port_ = std::make_shared<SharedUdpPort>(
+          webrtc::CreateEnvironment(), network_thread_.get(),
+          options_.shared_udp_port);
+    });
+  }
   if (!audio_device_module_) {
     task_queue_factory_ = webrtc::CreateDefaultTaskQueueFactory();
     worker_thread_->BlockingCall([&] { CreateAudioDeviceModule_w(); });
   }
 
+  if (options_.audio_target_buffer_ms > 0) {
+    worker_thread_->BlockingCall([this] {
+      webrtc::AudioDeviceModule::AudioLayer layer;
+      if (audio_device_module_->ActiveAudioLayer(&layer) != 0 ||
+          layer != webrtc::AudioDeviceModule::kLinuxPulseAudio) {
+        RTC_LOG(LS_WARNING)
+            << "audio_target_buffer_ms needs the PulseAudio backend.";
+      }
+    });
+  }
+
   if (!audio_processing_impl_) {
     worker_thread_->BlockingCall([this] {
       audio_processing_impl_ = new RefCountedObject<RTCAudioProcessingImpl>();
@@ -77,21 +186,19 @@ bool RTCPeerConnectionFactoryImpl::Initialize() {
   }
 
   if (!rtc_peerconnection_factory_) {
-    rtc_peerconnection_factory_ = CreatePeerConnectionFactory(
-        network_thread_.get(), worker_thread_.get(), signaling_thread_.get(),
-        audio_device_module_, webrtc::CreateBuiltinAudioEncoderFactory(),
-        webrtc::CreateBuiltinAudioDecoderFactory(),
-#if defined(USE_INTEL_MEDIA_SDK)
-        CreateIntelVideoEncoderFactory(), CreateIntelVideoDecoderFactory(),
-#else
-        webrtc::CreateBuiltinVideoEncoderFactory(),
-        webrtc::CreateBuiltinVideoDecoderFactory(),
-#endif
-        nullptr, audio_processing_impl_->GetAudioProcessing(), nullptr, nullptr,
+    InstallSocketBufferSizes(options_.udp_send_buffer_size,
+                             options_.udp_receive_buffer_size);
+    rtc_peerconnection_factory_ = CreateNativeFactory(
+        network_thread_.get(), worker_thread_.get(), audio_device_module_,
+        audio_processing_impl_->GetAudioProcessing(),
         audio_transport_factory_);
   }
 
-  if (!rtc_peerconnection_factory_.get()) {
+  if (!threads_applied)
+    RTC_LOG(LS_ERROR) << "Failed to apply the thread options";
+
+  if (!threads_applied || !rtc_peerconnection_factory_.get() ||
+      !CreateShards()) {
     Terminate();
     return false;
   }
@@ -99,7 +206,136 @@ bool RTCPeerConnectionFactoryImpl::Initialize() {
   return true;
 }
 
+webrtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+RTCPeerConnectionFactoryImpl::CreateNativeFactory(
+    webrtc::Thread* network_thread, webrtc::Thread* worker_thread,
+    webrtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module,
+    webrtc::scoped_refptr<webrtc::AudioProcessing> audio_processing,
+    webrtc::scoped_refptr<webrtc::AudioTransportFactory>
+        audio_transport_factory) {
+  // Same dependencies as the patched CreatePeerConnectionFactory(), which
+  // has no parameter for the SCTP transport factory.
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.network_thread = network_thread;
+  dependencies.worker_thread = worker_thread;
+  dependencies.signaling_thread = signaling_thread_.get();
+  dependencies.event_log_factory =
+      std::make_unique<webrtc::RtcEventLogFactory>();
+  dependencies.env = webrtc::CreateEnvironment();
+  dependencies.socket_factory = network_thread->socketserver();
+  dependencies.adm = audio_device_module;
+  dependencies.audio_encoder_factory =
+      webrtc::CreateBuiltinAudioEncoderFactory();
+  dependencies.audio_decoder_factory =
+      webrtc::CreateBuiltinAudioDecoderFactory();
+  if (audio_processing) {
+    dependencies.audio_processing_builder =
+        webrtc::CustomAudioProcessing(audio_processing);
+  } else {
+#ifndef WEBRTC_EXCLUDE_AUDIO_PROCESSING_MODULE
+    dependencies.audio_processing_builder =
+        std::make_unique<webrtc::BuiltinAudioProcessingBuilder>();
+#endif
+  }
+  dependencies.audio_transport_factory = audio_transport_factory;
+#if defined(USE_INTEL_MEDIA_SDK)
+  dependencies.video_encoder_factory = CreateIntelVideoEncoderFactory();
+  dependencies.video_decoder_factory = CreateIntelVideoDecoderFactory();
+#else
+  dependencies.video_encoder_factory =
+      webrtc::CreateBuiltinVideoEncoderFactory();
+  dependencies.video_decoder_factory =
+      webrtc::CreateBuiltinVideoDecoderFactory();
+#endif
+  if (HasSctpTuning(options_)) {
+    dependencies.sctp_factory =
+        std::make_unique<TunedSctpTransportFactory>(network_thread, options_);
+  }
+  webrtc::EnableMedia(dependencies);
+  return webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
+}
+
+bool RTCPeerConnectionFactoryImpl::CreateShards() {
+  shards_.clear();
+
+  std::unique_ptr<Shard> primary = std::make_unique<Shard>();
+  primary->network_thread = network_thread_.get();
+  primary->worker_thread = worker_thread_.get();
+  primary->factory = rtc_peerconnection_factory_;
+  shards_.push_back(std::move(primary));
+
+  for (uint32_t i = 1; i < options_.network_shards; i++) {
+    std::unique_ptr<Shard> shard = std::make_unique<Shard>();
+    std::string suffix = "_" + std::to_string(i);
+    shard->owned_network_thread = webrtc::Thread::CreateWithSocketServer();
+    shard->owned_network_thread->SetName(
+        ThreadName(options_.network_thread, "network_thread") + suffix,
+        nullptr);
+    RTC_CHECK(shard->owned_network_thread->Start())
+        << "Failed to start thread";
+    bool threads_applied = ApplyThreadOptions(
+        shard->owned_network_thread.get(), options_.network_thread);
+    shard->owned_worker_thread = webrtc::Thread::Create();
+    shard->owned_worker_thread->SetName(
+        ThreadName(options_.worker_thread, "worker_thread") + suffix, nullptr);
+    RTC_CHECK(shard->owned_worker_thread->Start()) << "Failed to start thread";
+    threads_applied &= ApplyThreadOptions(shard->owned_worker_thread.get(),
+                                          options_.worker_thread);
+    if (!threads_applied) {
+      RTC_LOG(LS_ERROR) << "Failed to apply the thread options of shard " << i;
+      return false;
+    }
+    shard->network_thread = shard->owned_network_thread.get();
+    shard->worker_thread = shard->owned_worker_thread.get();
+
+    // Only the first group drives the platform audio device.
+    Shard* raw = shard.get();
+    raw->worker_thread->BlockingCall([this, raw] {
+      raw->audio_device_module = webrtc::AudioDeviceModule::Create(
+          webrtc::AudioDeviceModule::kDummyAudio, task_queue_factory_.get());
+    });
+    raw->factory = CreateNativeFactory(raw->network_thread, raw->worker_thread,
+                                       raw->audio_device_module, nullptr,
+                                       nullptr);
+    if (!raw->factory) {
+      RTC_LOG(LS_ERROR) << "Failed to create factory for shard " << i;
+      return false;
+    }
+    shards_.push_back(std::move(shard));
+  }
+  return true;
+}
+
+void RTCPeerConnectionFactoryImpl::DestroyShards() {
+  // The threads stay alive until the factory is destroyed, connections that
+  // outlive Terminate() still reference them.
+  for (size_t i = 1; i < shards_.size(); i++) {
+    Shard* shard = shards_[i].get();
+    shard->factory = nullptr;
+    shard->worker_thread->BlockingCall(
+        [shard] { shard->audio_device_module = nullptr; });
+  }
+  if (!shards_.empty()) shards_[0]->factory = nullptr;
+}
+
 bool RTCPeerConnectionFactoryImpl::Terminate() {
+  // Runs on the signaling thread so that a fill in progress has finished and
+  // later pool tasks see the new generation.
+  std::deque<PooledPeerConnection> pooled;
+  signaling_thread_->BlockingCall([&] {
+    webrtc::MutexLock lock(&pool_mutex_);
+    pool_generation_++;
+    pool_options_ = RTCPeerConnectionPoolOptions();
+    pool_.swap(pooled);
+    certificates_.clear();
+  });
+  ClosePooled(&pooled);
+
+  DestroyShards();
+  // Connections still open keep it alive through their sockets, it goes
+  // away on the network thread with the last of them.
+  if (shared_udp_port_)
+    network_thread_->BlockingCall([this] { shared_udp_port_ = nullptr; });
   worker_thread_->BlockingCall([&] {
     audio_device_impl_ = nullptr;
     video_device_impl_ = nullptr;
@@ -127,23 +363,327 @@ void RTCPeerConnectionFactoryImpl::DestroyAudioDeviceModule_w() {
 scoped_refptr<RTCPeerConnection> RTCPeerConnectionFactoryImpl::Create(
     const RTCConfiguration& configuration,
     scoped_refptr<RTCMediaConstraints> constraints) {
-  scoped_refptr<RTCPeerConnection> peerconnection =
+  return AcquirePeerConnection(configuration, constraints);
+}
+
+void RTCPeerConnectionFactoryImpl::CreateAsync(
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints,
+    OnPeerConnectionCreated callback) {
+  scoped_refptr<RTCPeerConnectionFactoryImpl> self(this);
+  // The native factory proxy runs inline on the signaling thread, so the
+  // caller only pays for this hop.
+  signaling_thread_->PostTask(
+      [self, configuration, constraints, callback]() mutable {
+        scoped_refptr<RTCPeerConnectionImpl> peerconnection =
+            self->AcquirePeerConnection(configuration, constraints);
+        if (!peerconnection) {
+          callback(nullptr, RTCErrorType::kInvalidState,
+                   "PeerConnectionFactory is not initialized");
+          return;
+        }
+        RTCErrorType error = peerconnection->initialize_error_type();
+        if (error != RTCErrorType::kNone) {
+          std::string message = peerconnection->initialize_error_message();
+          self->Delete(peerconnection);
+          callback(nullptr, error, message);
+          return;
+        }
+        callback(peerconnection, RTCErrorType::kNone, "");
+      });
+}
+
+scoped_refptr<RTCPeerConnectionImpl>
+RTCPeerConnectionFactoryImpl::AcquirePeerConnection(
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints) {
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection =
+      TakePooledPeerConnection(configuration, constraints);
+  if (peerconnection) return peerconnection;
+  return CreatePeerConnection(configuration, constraints, TakeCertificate());
+}
+
+scoped_refptr<RTCPeerConnectionImpl>
+RTCPeerConnectionFactoryImpl::CreatePeerConnection(
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints,
+    webrtc::scoped_refptr<webrtc::RTCCertificate> certificate) {
+  size_t index = 0;
+  Shard* shard = nullptr;
+  {
+    webrtc::MutexLock lock(&peerconnections_mutex_);
+    if (shards_.empty() || !shards_[0]->factory) return nullptr;
+    // Additional groups have no audio and run their own worker thread, only
+    // connections that asked for it go there.
+    size_t candidates = configuration.use_network_shard ? shards_.size() : 1;
+    for (size_t i = 1; i < candidates; i++) {
+      if (shards_[i]->peerconnections < shards_[index]->peerconnections)
+        index = i;
+    }
+    shard = shards_[index].get();
+    shard->peerconnections++;
+  }
+
+  RTCConfiguration connection_configuration = configuration;
+  if (connection_configuration.min_port == 0 &&
+      connection_configuration.max_port == 0) {
+    connection_configuration.min_port = options_.min_port;
+    connection_configuration.max_port = options_.max_port;
+  }
+
+  // Allocators are created and used on the network thread. The shared port
+  // only exists on the first group.
+  std::unique_ptr<webrtc::PortAllocator> port_allocator;
+  if (shared_udp_port_ && index == 0) {
+    port_allocator = shard->network_thread->BlockingCall(
+        [this] { return shared_udp_port_->CreatePortAllocator(); });
+  }
+
+  // Initialize() blocks on the signaling thread, don't hold the lock.
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection =
       scoped_refptr<RTCPeerConnectionImpl>(
           new RefCountedObject<RTCPeerConnectionImpl>(
-              configuration, constraints, rtc_peerconnection_factory_));
-  peerconnections_.push_back(peerconnection);
+              connection_configuration, constraints, shard->factory,
+              shard->network_thread, signaling_thread_.get(), options_,
+              certificate, std::move(port_allocator)));
+
+  if (peerconnection->setup_tracer())
+    peerconnection->setup_tracer()->set_aggregator(setup_latency_);
+
+  webrtc::MutexLock lock(&peerconnections_mutex_);
+  peerconnections_[peerconnection.get()] =
+      std::make_pair(peerconnection, index);
   return peerconnection;
 }
 
 void RTCPeerConnectionFactoryImpl::Delete(
     scoped_refptr<RTCPeerConnection> peerconnection) {
-  peerconnections_.erase(
-      std::remove_if(
-          peerconnections_.begin(), peerconnections_.end(),
-          [peerconnection](const scoped_refptr<RTCPeerConnection> pc_) {
-            return pc_ == peerconnection;
-          }),
-      peerconnections_.end());
+  webrtc::MutexLock lock(&peerconnections_mutex_);
+  auto it = peerconnections_.find(peerconnection.get());
+  if (it == peerconnections_.end()) return;
+  size_t index = it->second.second;
+  if (index < shards_.size()) shards_[index]->peerconnections--;
+  peerconnections_.erase(it);
+}
+
+void RTCPeerConnectionFactoryImpl::ConfigurePeerConnectionPool(
+    const RTCPeerConnectionPoolOptions& options) {
+  std::deque<PooledPeerConnection> stale;
+  uint64_t generation = 0;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    pool_options_ = options;
+    if (!pool_options_.constraints)
+      pool_options_.constraints = RTCMediaConstraints::Create();
+    pool_.swap(stale);
+    generation = ++pool_generation_;
+  }
+  ClosePooled(&stale);
+  PostFillPool(generation);
+  SchedulePoolExpiry(generation);
+}
+
+void RTCPeerConnectionFactoryImpl::RefillPeerConnectionPool() {
+  uint64_t generation = 0;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    generation = pool_generation_;
+  }
+  PostFillPool(generation);
+}
+
+uint32_t RTCPeerConnectionFactoryImpl::pooled_peerconnections() {
+  webrtc::MutexLock lock(&pool_mutex_);
+  return static_cast<uint32_t>(pool_.size());
+}
+
+scoped_refptr<RTCPeerConnectionImpl>
+RTCPeerConnectionFactoryImpl::TakePooledPeerConnection(
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints) {
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection;
+  std::deque<PooledPeerConnection> expired;
+  uint64_t generation = 0;
+  bool refill = false;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    if (pool_.empty() ||
+        configuration != pool_options_.configuration ||
+        !SameConstraints(constraints, pool_options_.constraints))
+      return nullptr;
+
+    int64_t now = webrtc::TimeMillis();
+    while (!pool_.empty() && !peerconnection) {
+      PooledPeerConnection entry = pool_.front();
+      pool_.pop_front();
+      if (pool_options_.ttl_ms > 0 &&
+          now - entry.created_ms >= pool_options_.ttl_ms) {
+        expired.push_back(entry);
+      } else {
+        peerconnection = entry.peerconnection;
+      }
+    }
+    generation = pool_generation_;
+    refill = pool_options_.refill == RTCPeerConnectionPoolRefill::kImmediate;
+  }
+  ClosePooled(&expired);
+  if (refill) PostFillPool(generation);
+  // Setup is measured from the handout, not from when the pool built it.
+  if (peerconnection && peerconnection->setup_tracer())
+    peerconnection->setup_tracer()->Restart();
+  return peerconnection;
+}
+
+webrtc::scoped_refptr<webrtc::RTCCertificate>
+RTCPeerConnectionFactoryImpl::TakeCertificate() {
+  webrtc::scoped_refptr<webrtc::RTCCertificate> certificate;
+  uint64_t generation = 0;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    if (certificates_.empty()) return nullptr;
+    certificate = certificates_.back();
+    certificates_.pop_back();
+    if (pool_options_.refill != RTCPeerConnectionPoolRefill::kImmediate)
+      return certificate;
+    generation = pool_generation_;
+  }
+  PostFillPool(generation);
+  return certificate;
+}
+
+void RTCPeerConnectionFactoryImpl::PostFillPool(uint64_t generation) {
+  signaling_thread_->PostTask([this, generation] { FillPool_s(generation); });
+}
+
+void RTCPeerConnectionFactoryImpl::FillPool_s(uint64_t generation) {
+  // Builds one certificate or connection per task and posts the next step,
+  // so CreateAsync() requests queued meanwhile are not held up by a refill.
+  RTCConfiguration configuration;
+  scoped_refptr<RTCMediaConstraints> constraints;
+  bool need_certificate = false;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    if (generation != pool_generation_) return;
+    need_certificate = certificates_.size() < pool_options_.certificates;
+    if (!need_certificate && pool_.size() >= pool_options_.size) return;
+    configuration = pool_options_.configuration;
+    constraints = pool_options_.constraints;
+  }
+
+  if (need_certificate) {
+    webrtc::scoped_refptr<webrtc::RTCCertificate> certificate =
+        webrtc::RTCCertificateGenerator::GenerateCertificate(
+            webrtc::KeyParams::ECDSA(), std::nullopt);
+    if (!certificate) {
+      RTC_LOG(LS_ERROR) << "Failed to generate a pooled certificate";
+      return;
+    }
+    {
+      webrtc::MutexLock lock(&pool_mutex_);
+      if (generation != pool_generation_) return;
+      certificates_.push_back(certificate);
+    }
+    PostFillPool(generation);
+    return;
+  }
+
+  configuration.ice_candidate_pool_size =
+      std::max(configuration.ice_candidate_pool_size, 1);
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection =
+      CreatePeerConnection(configuration, constraints);
+  if (!peerconnection) return;
+  if (peerconnection->initialize_error_type() != RTCErrorType::kNone) {
+    RTC_LOG(LS_ERROR) << "Failed to create a pooled peer connection: "
+                      << peerconnection->initialize_error_message();
+    Delete(peerconnection);
+    return;
+  }
+
+  PooledPeerConnection entry;
+  entry.peerconnection = peerconnection;
+  entry.created_ms = webrtc::TimeMillis();
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    if (generation == pool_generation_) {
+      pool_.push_back(entry);
+      PostFillPool(generation);
+      return;
+    }
+  }
+
+  // Reconfigured while the connection was being built.
+  Delete(peerconnection);
+  peerconnection->Close();
+}
+
+void RTCPeerConnectionFactoryImpl::SchedulePoolExpiry(uint64_t generation) {
+  uint32_t ttl_ms = 0;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    if (generation != pool_generation_ || pool_options_.size == 0) return;
+    ttl_ms = pool_options_.ttl_ms;
+  }
+  if (ttl_ms == 0) return;
+  signaling_thread_->PostDelayedTask(
+      [this, generation] { ExpirePool_s(generation); },
+      webrtc::TimeDelta::Millis(std::max<uint32_t>(ttl_ms / 2, 1000)));
+}
+
+void RTCPeerConnectionFactoryImpl::ExpirePool_s(uint64_t generation) {
+  std::deque<PooledPeerConnection> expired;
+  bool refill = false;
+  {
+    webrtc::MutexLock lock(&pool_mutex_);
+    if (generation != pool_generation_) return;
+    int64_t now = webrtc::TimeMillis();
+    while (!pool_.empty() &&
+           now - pool_.front().created_ms >= pool_options_.ttl_ms) {
+      expired.push_back(pool_.front());
+      pool_.pop_front();
+    }
+    refill = pool_options_.refill == RTCPeerConnectionPoolRefill::kImmediate;
+  }
+  ClosePooled(&expired);
+  if (refill) FillPool_s(generation);
+  SchedulePoolExpiry(generation);
+}
+
+void RTCPeerConnectionFactoryImpl::ClosePooled(
+    std::deque<PooledPeerConnection>* pooled) {
+  for (const PooledPeerConnection& entry : *pooled) {
+    Delete(entry.peerconnection);
+    entry.peerconnection->Close();
+  }
+  pooled->clear();
+}
+
+RTCSetupLatencyStats RTCPeerConnectionFactoryImpl::GetSetupLatencyStats(
+    RTCSetupMilestone milestone) {
+  return setup_latency_->Stats(milestone);
+}
+
+RTCUdpDropCounters RTCPeerConnectionFactoryImpl::GetUdpDropCounters() {
+  return ReadUdpDropCounters();
+}
+
+vector<RTCPeerConnectionShardLoad>
+RTCPeerConnectionFactoryImpl::GetShardLoad() {
+  webrtc::MutexLock lock(&peerconnections_mutex_);
+  std::vector<RTCPeerConnectionShardLoad> loads;
+  for (auto& shard : shards_) {
+    RTCPeerConnectionShardLoad load;
+    load.peerconnections = shard->peerconnections;
+    load.network_thread_delay_us = *shard->network_thread_delay_us;
+    loads.push_back(load);
+
+    std::shared_ptr<std::atomic<int64_t>> delay_us =
+        shard->network_thread_delay_us;
+    int64_t posted_us = webrtc::TimeMicros();
+    shard->network_thread->PostTask([delay_us, posted_us] {
+      *delay_us = webrtc::TimeMicros() - posted_us;
+    });
+  }
+  return loads;
 }
 
 scoped_refptr<RTCAudioDevice> RTCPeerConnectionFactoryImpl::GetAudioDevice() {
@@ -204,7 +744,9 @@ RTCPeerConnectionFactoryImpl::CreateAudioSourceWithOptions(
 
 scoped_refptr<RTCAudioSource> RTCPeerConnectionFactoryImpl::CreateAudioSource(
     const string audio_source_label, RTCAudioSource::SourceType source_type) {
-  auto options = webrtc::AudioOptions();
+  auto options = audio_processing_impl_
+                     ? audio_processing_impl_->GetAudioOptions()
+                     : webrtc::AudioOptions();
   webrtc::scoped_refptr<libwebrtc::LocalAudioSource> rtc_source_track =
       CreateAudioSourceWithOptions(&options, source_type == RTCAudioSource::SourceType::kCustom);
   scoped_refptr<RTCAudioSourceImpl> source = scoped_refptr<RTCAudioSourceImpl>(
@@ -217,7 +759,8 @@ scoped_refptr<RTCDesktopDevice>
 RTCPeerConnectionFactoryImpl::GetDesktopDevice() {
   if (!desktop_device_impl_) {
     desktop_device_impl_ = scoped_refptr<RTCDesktopDeviceImpl>(
-        new RefCountedObject<RTCDesktopDeviceImpl>(signaling_thread_.get()));
+        new RefCountedObject<RTCDesktopDeviceImpl>(
+            signaling_thread_.get(), options_.desktop_capture_thread));
   }
   return desktop_device_impl_;
 }
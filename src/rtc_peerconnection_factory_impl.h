@@ -1,15 +1,22 @@
 #ifndef LIB_WEBRTC_MEDIA_SESSION_FACTORY_IMPL_HXX
 #define LIB_WEBRTC_MEDIA_SESSION_FACTORY_IMPL_HXX
 
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "api/media_stream_interface.h"
 #include "api/peer_connection_interface.h"
 #include "api/task_queue/task_queue_factory.h"
 #include "rtc_audio_device_impl.h"
 #include "rtc_audio_processing_impl.h"
+#include "rtc_base/rtc_certificate.h"
+#include "rtc_base/synchronization/mutex.h"
 #include "rtc_base/thread.h"
 #include "rtc_peerconnection.h"
+#include "rtc_peerconnection_impl.h"
 #include "rtc_peerconnection_factory.h"
 #include "rtc_video_device_impl.h"
 
@@ -21,12 +28,17 @@
 
 #include "src/internal/custom_audio_transport_impl.h"
 #include "src/internal/local_audio_track.h"
+#include "src/internal/setup_tracer.h"
+#include "src/internal/shared_udp_port.h"
+#include "src/internal/thread_options.h"
 
 namespace libwebrtc {
 
 class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
  public:
-  RTCPeerConnectionFactoryImpl();
+  explicit RTCPeerConnectionFactoryImpl(
+      const RTCPeerConnectionFactoryOptions& options =
+          RTCPeerConnectionFactoryOptions());
 
   virtual ~RTCPeerConnectionFactoryImpl();
 
@@ -38,8 +50,26 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
       const RTCConfiguration& configuration,
       scoped_refptr<RTCMediaConstraints> constraints) override;
 
+  void CreateAsync(const RTCConfiguration& configuration,
+                   scoped_refptr<RTCMediaConstraints> constraints,
+                   OnPeerConnectionCreated callback) override;
+
   void Delete(scoped_refptr<RTCPeerConnection> peerconnection) override;
 
+  void ConfigurePeerConnectionPool(
+      const RTCPeerConnectionPoolOptions& options) override;
+
+  void RefillPeerConnectionPool() override;
+
+  uint32_t pooled_peerconnections() override;
+
+  vector<RTCPeerConnectionShardLoad> GetShardLoad() override;
+
+  RTCSetupLatencyStats GetSetupLatencyStats(
+      RTCSetupMilestone milestone) override;
+
+  RTCUdpDropCounters GetUdpDropCounters() override;
+
   scoped_refptr<RTCAudioDevice> GetAudioDevice() override;
 
   scoped_refptr<RTCVideoDevice> GetVideoDevice() override;
@@ -82,11 +112,55 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
 
   webrtc::Thread* signaling_thread() { return signaling_thread_.get(); }
 
+  // Joins the signaling threads of factories whose last reference was
+  // dropped on their own signaling thread. Must not run on one of them.
+  static void JoinRetiredThreads();
+
  protected:
   void CreateAudioDeviceModule_w();
 
   void DestroyAudioDeviceModule_w();
 
+  webrtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
+  CreateNativeFactory(
+      webrtc::Thread* network_thread, webrtc::Thread* worker_thread,
+      webrtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module,
+      webrtc::scoped_refptr<webrtc::AudioProcessing> audio_processing,
+      webrtc::scoped_refptr<webrtc::AudioTransportFactory>
+          audio_transport_factory);
+
+  // Hands out a pooled connection if one matches, creates one otherwise.
+  scoped_refptr<RTCPeerConnectionImpl> AcquirePeerConnection(
+      const RTCConfiguration& configuration,
+      scoped_refptr<RTCMediaConstraints> constraints);
+
+  // Creates a connection on the least loaded shard and registers it.
+  scoped_refptr<RTCPeerConnectionImpl> CreatePeerConnection(
+      const RTCConfiguration& configuration,
+      scoped_refptr<RTCMediaConstraints> constraints,
+      webrtc::scoped_refptr<webrtc::RTCCertificate> certificate = nullptr);
+
+  scoped_refptr<RTCPeerConnectionImpl> TakePooledPeerConnection(
+      const RTCConfiguration& configuration,
+      scoped_refptr<RTCMediaConstraints> constraints);
+
+  webrtc::scoped_refptr<webrtc::RTCCertificate> TakeCertificate();
+
+  // Pool tasks carry the generation they were posted for and do nothing once
+  // the pool has been reconfigured or torn down.
+  void PostFillPool(uint64_t generation);
+
+  void FillPool_s(uint64_t generation);
+
+  void ExpirePool_s(uint64_t generation);
+
+  void SchedulePoolExpiry(uint64_t generation);
+
+  // Creates the native factories of the thread groups beyond the first one.
+  bool CreateShards();
+
+  void DestroyShards();
+
   webrtc::scoped_refptr<libwebrtc::LocalAudioSource>
   CreateAudioSourceWithOptions(webrtc::AudioOptions* options,
                                bool is_custom_source = false);
@@ -101,6 +175,29 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
       scoped_refptr<RTCMediaConstraints> constraints);
 #endif
  private:
+  // A network/worker thread group with its own native factory. The first
+  // shard aliases the factory's primary threads and factory.
+  struct Shard {
+    webrtc::Thread* network_thread = nullptr;
+    webrtc::Thread* worker_thread = nullptr;
+    std::unique_ptr<webrtc::Thread> owned_network_thread;
+    std::unique_ptr<webrtc::Thread> owned_worker_thread;
+    webrtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module;
+    webrtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory;
+    uint32_t peerconnections = 0;
+    // Shared with in-flight probe tasks.
+    std::shared_ptr<std::atomic<int64_t>> network_thread_delay_us =
+        std::make_shared<std::atomic<int64_t>>(0);
+  };
+
+  struct PooledPeerConnection {
+    scoped_refptr<RTCPeerConnectionImpl> peerconnection;
+    int64_t created_ms = 0;
+  };
+
+  void ClosePooled(std::deque<PooledPeerConnection>* pooled);
+
+  RTCPeerConnectionFactoryOptions options_;
   std::unique_ptr<webrtc::Thread> worker_thread_;
   std::unique_ptr<webrtc::Thread> signaling_thread_;
   std::unique_ptr<webrtc::Thread> network_thread_;
@@ -113,7 +210,23 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
 #ifdef RTC_DESKTOP_DEVICE
   scoped_refptr<RTCDesktopDeviceImpl> desktop_device_impl_;
 #endif
-  std::list<scoped_refptr<RTCPeerConnection>> peerconnections_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  webrtc::Mutex peerconnections_mutex_;
+  // Connection to the index of the shard it runs on.
+  std::unordered_map<RTCPeerConnection*,
+                     std::pair<scoped_refptr<RTCPeerConnection>, size_t>>
+      peerconnections_;
+  webrtc::Mutex pool_mutex_;
+  RTCPeerConnectionPoolOptions pool_options_;
+  // Oldest first.
+  std::deque<PooledPeerConnection> pool_;
+  std::vector<webrtc::scoped_refptr<webrtc::RTCCertificate>> certificates_;
+  uint64_t pool_generation_ = 0;
+  // Sockets of RTCPeerConnectionFactoryOptions::shared_udp_port, nullptr if
+  // unused. Lives on the network thread of the first group.
+  std::shared_ptr<SharedUdpPort> shared_udp_port_;
+  std::shared_ptr<SetupLatencyAggregator> setup_latency_ =
+      std::make_shared<SetupLatencyAggregator>();
   std::unique_ptr<webrtc::TaskQueueFactory> task_queue_factory_;
   webrtc::scoped_refptr<webrtc::CustomAudioTransportFactory>
       audio_transport_factory_;
@@ -1,13 +1,18 @@
 #include "rtc_peerconnection_impl.h"
 
+#include <algorithm>
 #include <functional>
+#include <optional>
 #include <utility>
 #include <vector>
 
 #include "api/data_channel_interface.h"
 #include "api/jsep.h"
+#include "api/units/time_delta.h"
 #include "pc/media_session.h"
+#include "pc/session_description.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_data_channel_impl.h"
 #include "rtc_ice_candidate_impl.h"
 #include "rtc_media_stream_impl.h"
@@ -15,6 +20,7 @@
 #include "rtc_rtp_receiver_impl.h"
 #include "rtc_rtp_sender_impl.h"
 #include "rtc_rtp_transceiver_impl.h"
+#include "rtc_session_description_impl.h"
 
 using webrtc::Thread;
 
@@ -136,10 +142,14 @@ class SetSessionDescriptionObserverProxy
     : public webrtc::SetLocalDescriptionObserverInterface,
       public webrtc::SetRemoteDescriptionObserverInterface {
  public:
-  SetSessionDescriptionObserverProxy(OnSetSdpSuccess success_callback,
-                                     OnSetSdpFailure failure_callback)
+  SetSessionDescriptionObserverProxy(
+      OnSetSdpSuccess success_callback, OnSetSdpFailure failure_callback,
+      std::shared_ptr<SetupTracer> tracer = nullptr,
+      std::function<void()> applied = nullptr)
       : success_callback_(success_callback),
-        failure_callback_(failure_callback) {}
+        failure_callback_(failure_callback),
+        tracer_(tracer),
+        applied_(applied) {}
   ~SetSessionDescriptionObserverProxy() {}
   static webrtc::scoped_refptr<SetSessionDescriptionObserverProxy> Create(
       OnSetSdpSuccess success_callback, OnSetSdpFailure failure_callback) {
@@ -149,6 +159,9 @@ class SetSessionDescriptionObserverProxy
   virtual void OnSetLocalDescriptionComplete(webrtc::RTCError error) override {
     RTC_LOG(LS_INFO) << __FUNCTION__;
     if (error.ok()) {
+      if (applied_) applied_();
+      if (tracer_)
+        tracer_->Mark(RTCSetupMilestone::kSetLocalDescriptionComplete);
       success_callback_();
     } else {
       failure_callback_(error.message());
@@ -158,6 +171,9 @@ class SetSessionDescriptionObserverProxy
   virtual void OnSetRemoteDescriptionComplete(webrtc::RTCError error) override {
     RTC_LOG(LS_INFO) << __FUNCTION__;
     if (error.ok()) {
+      if (applied_) applied_();
+      if (tracer_)
+        tracer_->Mark(RTCSetupMilestone::kSetRemoteDescriptionComplete);
       success_callback_();
     } else {
       failure_callback_(error.message());
@@ -176,28 +192,59 @@ class SetSessionDescriptionObserverProxy
  private:
   OnSetSdpSuccess success_callback_;
   OnSetSdpFailure failure_callback_;
+  std::shared_ptr<SetupTracer> tracer_;
+  std::function<void()> applied_;
 };
 
 class CreateSessionDescriptionObserverProxy
     : public webrtc::CreateSessionDescriptionObserver {
  public:
   static CreateSessionDescriptionObserverProxy* Create(
-      OnSdpCreateSuccess success_callback,
-      OnSdpCreateFailure failure_callback) {
+      OnSdpCreateSuccess success_callback, OnSdpCreateFailure failure_callback,
+      uint32_t sctp_max_message_size = 0, bool ice_lite = false,
+      std::shared_ptr<SetupTracer> tracer = nullptr) {
     return new webrtc::RefCountedObject<CreateSessionDescriptionObserverProxy>(
-        success_callback, failure_callback);
+        success_callback, failure_callback, sctp_max_message_size, ice_lite,
+        tracer);
   }
 
   CreateSessionDescriptionObserverProxy(OnSdpCreateSuccess success_callback,
-                                        OnSdpCreateFailure failure_callback)
+                                        OnSdpCreateFailure failure_callback,
+                                        uint32_t sctp_max_message_size,
+                                        bool ice_lite,
+                                        std::shared_ptr<SetupTracer> tracer)
       : success_callback_(success_callback),
-        failure_callback_(failure_callback) {}
+        failure_callback_(failure_callback),
+        sctp_max_message_size_(sctp_max_message_size),
+        ice_lite_(ice_lite),
+        tracer_(tracer) {}
 
  public:
   virtual void OnSuccess(webrtc::SessionDescriptionInterface* desc) {
+    if (sctp_max_message_size_ > 0) {
+      webrtc::SctpDataContentDescription* data_desc =
+          webrtc::GetFirstDataContentDescription(desc->description());
+      if (data_desc)
+        data_desc->set_max_message_size(
+            static_cast<int>(sctp_max_message_size_));
+    }
+    // The native connection has no local ICE-lite setting, announcing it
+    // makes full agents take the controlling role. Should both sides end
+    // up controlling, the native role conflict handling resolves it.
+    if (ice_lite_) {
+      for (webrtc::TransportInfo& info :
+           desc->description()->transport_infos()) {
+        info.description.ice_mode = webrtc::ICEMODE_LITE;
+      }
+    }
     std::string sdp;
     desc->ToString(&sdp);
     std::string type = desc->type();
+    if (tracer_) {
+      tracer_->Mark(desc->GetType() == webrtc::SdpType::kOffer
+                        ? RTCSetupMilestone::kCreateOfferComplete
+                        : RTCSetupMilestone::kCreateAnswerComplete);
+    }
     success_callback_(sdp.c_str(), type.c_str());
   }
 
@@ -208,18 +255,33 @@ class CreateSessionDescriptionObserverProxy
  private:
   OnSdpCreateSuccess success_callback_;
   OnSdpCreateFailure failure_callback_;
+  uint32_t sctp_max_message_size_;
+  bool ice_lite_;
+  std::shared_ptr<SetupTracer> tracer_;
 };
 
 RTCPeerConnectionImpl::RTCPeerConnectionImpl(
     const RTCConfiguration& configuration,
     scoped_refptr<RTCMediaConstraints> constraints,
     webrtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
-        peer_connection_factory)
+        peer_connection_factory,
+    webrtc::Thread* network_thread, webrtc::Thread* signaling_thread,
+    const RTCPeerConnectionFactoryOptions& factory_options,
+    webrtc::scoped_refptr<webrtc::RTCCertificate> certificate,
+    std::unique_ptr<webrtc::PortAllocator> port_allocator)
     : rtc_peerconnection_factory_(peer_connection_factory),
+      network_thread_(network_thread),
+      signaling_thread_(signaling_thread),
       configuration_(configuration),
+      sctp_receive_window_(factory_options.sctp_receive_window),
+      certificate_(certificate),
+      port_allocator_(std::move(port_allocator)),
+      ice_lite_(factory_options.ice_lite),
       constraints_(constraints),
       callback_crt_sec_(new webrtc::Mutex()) {
   RTC_LOG(LS_INFO) << __FUNCTION__ << ": ctor";
+  if (configuration_.trace_connection_setup)
+    setup_tracer_ = std::make_shared<SetupTracer>();
   Initialize();
 }
 
@@ -301,10 +363,14 @@ void RTCPeerConnectionImpl::OnRemoveStream(
 
 void RTCPeerConnectionImpl::OnDataChannel(
     webrtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel) {
-  data_channel_ = scoped_refptr<RTCDataChannelImpl>(
-      new RefCountedObject<RTCDataChannelImpl>(rtc_data_channel));
-
-  if (observer_) observer_->OnDataChannel(data_channel_);
+  scoped_refptr<RTCDataChannel> data_channel =
+      scoped_refptr<RTCDataChannelImpl>(
+          new RefCountedObject<RTCDataChannelImpl>(
+              rtc_data_channel, network_thread_,
+              data_channels_.CloseNotifier()));
+  data_channels_.Add(data_channel);
+
+  if (observer_) observer_->OnDataChannel(data_channel);
 }
 
 void RTCPeerConnectionImpl::OnRenegotiationNeeded() {
@@ -315,33 +381,129 @@ void RTCPeerConnectionImpl::OnRenegotiationNeeded() {
 
 void RTCPeerConnectionImpl::OnConnectionChange(
     webrtc::PeerConnectionInterface::PeerConnectionState new_state) {
+  if (setup_tracer_ &&
+      new_state == webrtc::PeerConnectionInterface::PeerConnectionState::
+                       kConnected &&
+      !setup_tracer_->Reached(RTCSetupMilestone::kDtlsConnected)) {
+    MarkSetupMilestone(RTCSetupMilestone::kDtlsConnected);
+    ProbeMediaMilestones();
+  }
   if (observer_)
     observer_->OnPeerConnectionState(peer_connection_state_map[new_state]);
 }
 
+void RTCPeerConnectionImpl::OnIceCandidatesRemoved(
+    const std::vector<webrtc::Candidate>& candidates) {
+  // The native stack drops removed candidates from the local description.
+  RTC_LOG(LS_INFO) << __FUNCTION__ << ", " << candidates.size()
+                   << " candidates";
+  InvalidateDescriptionCache();
+}
+
 void RTCPeerConnectionImpl::OnIceGatheringChange(
     webrtc::PeerConnectionInterface::IceGatheringState new_state) {
+  InvalidateDescriptionCache();
+  // Hand out the last batch before announcing the end of gathering.
+  if (new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete)
+    FlushIceCandidates();
   if (observer_)
     observer_->OnIceGatheringState(ice_gathering_state_map[new_state]);
 }
 
 void RTCPeerConnectionImpl::OnIceConnectionChange(
     webrtc::PeerConnectionInterface::IceConnectionState new_state) {
+  if (new_state == webrtc::PeerConnectionInterface::kIceConnectionChecking) {
+    MarkSetupMilestone(RTCSetupMilestone::kIceChecking);
+  } else if (new_state ==
+                 webrtc::PeerConnectionInterface::kIceConnectionConnected ||
+             new_state ==
+                 webrtc::PeerConnectionInterface::kIceConnectionCompleted) {
+    MarkSetupMilestone(RTCSetupMilestone::kIceConnected);
+  }
   if (observer_)
     observer_->OnIceConnectionState(ice_connection_state_map[new_state]);
 }
 
 void RTCPeerConnectionImpl::OnSignalingChange(
     webrtc::PeerConnectionInterface::SignalingState new_state) {
+  InvalidateDescriptionCache();
   if (observer_) observer_->OnSignalingState(signaling_state_map[new_state]);
 }
 
 void RTCPeerConnectionImpl::AddCandidate(const string mid, int mid_mline_index,
                                          const string cand_sdp) {
   webrtc::SdpParseError error;
-  webrtc::IceCandidateInterface* candidate = webrtc::CreateIceCandidate(
-      to_std_string(mid), mid_mline_index, to_std_string(cand_sdp), &error);
-  if (candidate != nullptr) rtc_peerconnection_->AddIceCandidate(candidate);
+  std::unique_ptr<webrtc::IceCandidateInterface> candidate(
+      webrtc::CreateIceCandidate(to_std_string(mid), mid_mline_index,
+                                 to_std_string(cand_sdp), &error));
+  if (!candidate) {
+    RTC_LOG(LS_WARNING) << "Failed to parse candidate: " << error.description;
+    return;
+  }
+  rtc_peerconnection_->AddIceCandidate(candidate.get());
+  InvalidateDescriptionCache();
+}
+
+void RTCPeerConnectionImpl::AddCandidates(
+    const vector<RTCIceCandidateInit> candidates,
+    OnAddCandidatesComplete callback) {
+  struct Batch {
+    std::vector<RTCErrorType> results;
+    std::vector<std::unique_ptr<webrtc::IceCandidateInterface>> parsed;
+    size_t pending = 0;
+    OnAddCandidatesComplete callback;
+  };
+  auto batch = std::make_shared<Batch>();
+  batch->results.resize(candidates.size(), RTCErrorType::kNone);
+  batch->parsed.resize(candidates.size());
+  batch->callback = callback;
+
+  // Parse everything here, only the native calls go to the signaling thread.
+  for (size_t i = 0; i < candidates.size(); i++) {
+    webrtc::SdpParseError error;
+    batch->parsed[i].reset(webrtc::CreateIceCandidate(
+        candidates[i].sdp_mid.std_string(), candidates[i].sdp_mline_index,
+        candidates[i].candidate.std_string(), &error));
+    if (!batch->parsed[i]) {
+      RTC_LOG(LS_WARNING) << "Failed to parse candidate: "
+                          << error.description;
+      batch->results[i] = RTCErrorType::kSyntaxError;
+    } else {
+      batch->pending++;
+    }
+  }
+
+  webrtc::scoped_refptr<webrtc::PeerConnectionInterface> peerconnection =
+      rtc_peerconnection_;
+  if (!peerconnection || batch->pending == 0) {
+    for (size_t i = 0; i < batch->parsed.size(); i++) {
+      if (batch->parsed[i]) batch->results[i] = RTCErrorType::kInvalidState;
+    }
+    // Still reported on the signaling thread, as documented, never from
+    // inside this call.
+    if (batch->callback) {
+      signaling_thread_->PostTask(
+          [batch] { batch->callback(batch->results); });
+    }
+    return;
+  }
+
+  scoped_refptr<RTCPeerConnectionImpl> self(this);
+  signaling_thread_->PostTask([self, peerconnection, batch] {
+    // The proxy runs inline on the signaling thread; completions may be
+    // deferred by the operations chain but all arrive on this thread.
+    for (size_t i = 0; i < batch->parsed.size(); i++) {
+      if (!batch->parsed[i]) continue;
+      peerconnection->AddIceCandidate(
+          std::move(batch->parsed[i]),
+          [self, batch, i](webrtc::RTCError error) {
+            if (error.ok()) self->InvalidateDescriptionCache();
+            batch->results[i] = ToRTCErrorType(error.type());
+            if (--batch->pending == 0 && batch->callback)
+              batch->callback(batch->results);
+          });
+    }
+  });
 }
 
 void RTCPeerConnectionImpl::OnIceCandidate(
@@ -362,18 +524,68 @@ void RTCPeerConnectionImpl::OnIceCandidate(
   }
 #endif
 
-  std::string cand_sdp;
-  if (observer_ && candidate->ToString(&cand_sdp)) {
-    SdpParseError error;
-    scoped_refptr<RTCIceCandidate> cand =
-        RTCIceCandidate::Create(cand_sdp.c_str(), candidate->sdp_mid().c_str(),
-                                candidate->sdp_mline_index(), &error);
-    observer_->OnIceCandidate(cand);
+  RTC_LOG(LS_INFO) << __FUNCTION__ << ", mid " << candidate->sdp_mid()
+                   << ", mline " << candidate->sdp_mline_index() << ", "
+                   << candidate->candidate().ToString();
+
+  // Copy the parsed candidate instead of a ToString()/parse round trip, the
+  // SDP line is only produced if the application asks for it.
+  scoped_refptr<RTCIceCandidate> cand = scoped_refptr<RTCIceCandidateImpl>(
+      new RefCountedObject<RTCIceCandidateImpl>(webrtc::CreateIceCandidate(
+          candidate->sdp_mid(), candidate->sdp_mline_index(),
+          candidate->candidate())));
+
+  MarkSetupMilestone(RTCSetupMilestone::kFirstLocalCandidate);
+  InvalidateDescriptionCache();
+
+  int window_ms = candidate_batch_window_ms_;
+  if (window_ms == 0) {
+    if (observer_) observer_->OnIceCandidate(cand);
+    return;
   }
 
-  RTC_LOG(LS_INFO) << __FUNCTION__ << ", mid " << candidate->sdp_mid()
-                   << ", mline " << candidate->sdp_mline_index() << ", sdp"
-                   << cand_sdp;
+  pending_candidates_.push_back(cand);
+  if (window_ms > 0 && !candidate_flush_scheduled_) {
+    candidate_flush_scheduled_ = true;
+    scoped_refptr<RTCPeerConnectionImpl> self(this);
+    signaling_thread_->PostDelayedTask([self] { self->FlushIceCandidates(); },
+                                       webrtc::TimeDelta::Millis(window_ms));
+  }
+}
+
+void RTCPeerConnectionImpl::MarkSetupMilestone(RTCSetupMilestone milestone) {
+  if (setup_tracer_) setup_tracer_->Mark(milestone);
+}
+
+void RTCPeerConnectionImpl::ProbeMediaMilestones() {
+  // Connections without media in one direction never reach every milestone,
+  // give up after a while.
+  const int kProbeIntervalMs = 100;
+  const int64_t kProbeTimeoutUs = 10 * webrtc::kNumMicrosecsPerSec;
+
+  webrtc::scoped_refptr<webrtc::PeerConnectionInterface> peerconnection =
+      rtc_peerconnection_;
+  if (!peerconnection || !setup_tracer_) return;
+  if (setup_tracer_->Reached(RTCSetupMilestone::kFirstRtpSent) &&
+      setup_tracer_->Reached(RTCSetupMilestone::kFirstRtpReceived) &&
+      setup_tracer_->Reached(RTCSetupMilestone::kFirstFrameDecoded))
+    return;
+  if (setup_tracer_->Elapsed() > kProbeTimeoutUs) return;
+
+  peerconnection->GetStats(
+      webrtc::make_ref_counted<SetupStatsProbe>(setup_tracer_).get());
+  scoped_refptr<RTCPeerConnectionImpl> self(this);
+  signaling_thread_->PostDelayedTask(
+      [self] { self->ProbeMediaMilestones(); },
+      webrtc::TimeDelta::Millis(kProbeIntervalMs));
+}
+
+void RTCPeerConnectionImpl::FlushIceCandidates() {
+  candidate_flush_scheduled_ = false;
+  if (pending_candidates_.empty()) return;
+  std::vector<scoped_refptr<RTCIceCandidate>> candidates;
+  candidates.swap(pending_candidates_);
+  if (observer_) observer_->OnIceCandidates(candidates);
 }
 
 void RTCPeerConnectionImpl::RegisterRTCPeerConnectionObserver(
@@ -387,10 +599,113 @@ void RTCPeerConnectionImpl::DeRegisterRTCPeerConnectionObserver() {
   observer_ = nullptr;
 }
 
+static void SetIceTiming(int value_ms, std::optional<int>* field) {
+  if (value_ms >= 0) *field = value_ms;
+}
+
+static void ApplyIceTuning(
+    const RTCConfiguration& configuration,
+    webrtc::PeerConnectionInterface::RTCConfiguration* config) {
+  config->ice_candidate_pool_size = configuration.ice_candidate_pool_size;
+
+  if (configuration.ice_profile == RTCIceProfile::kFastConnect) {
+    // Gather before the first offer so the candidates are ready when
+    // SetLocalDescription() runs.
+    config->ice_candidate_pool_size =
+        std::max(config->ice_candidate_pool_size, 1);
+    config->continual_gathering_policy =
+        webrtc::PeerConnectionInterface::GATHER_CONTINUALLY;
+    config->presume_writable_when_fully_relayed = true;
+    config->prioritize_most_likely_ice_candidate_pairs = true;
+    config->ice_check_interval_weak_connectivity = 25;
+    config->ice_unwritable_timeout = 2500;
+    config->ice_inactive_timeout = 5000;
+    config->ice_connection_receiving_timeout = 1000;
+  }
+
+  SetIceTiming(configuration.ice_check_interval_weak_connectivity_ms,
+               &config->ice_check_interval_weak_connectivity);
+  SetIceTiming(configuration.ice_check_interval_strong_connectivity_ms,
+               &config->ice_check_interval_strong_connectivity);
+  SetIceTiming(configuration.ice_check_min_interval_ms,
+               &config->ice_check_min_interval);
+  SetIceTiming(configuration.ice_unwritable_timeout_ms,
+               &config->ice_unwritable_timeout);
+  SetIceTiming(configuration.ice_inactive_timeout_ms,
+               &config->ice_inactive_timeout);
+  SetIceTiming(configuration.ice_connection_receiving_timeout_ms,
+               &config->ice_connection_receiving_timeout);
+}
+
+static webrtc::Priority ToNativePriority(RTCNetworkPriority priority) {
+  switch (priority) {
+    case RTCNetworkPriority::kVeryLow:
+      return webrtc::Priority::kVeryLow;
+    case RTCNetworkPriority::kMedium:
+      return webrtc::Priority::kMedium;
+    case RTCNetworkPriority::kHigh:
+      return webrtc::Priority::kHigh;
+    case RTCNetworkPriority::kLow:
+    default:
+      return webrtc::Priority::kLow;
+  }
+}
+
+void RTCPeerConnectionImpl::ApplyNetworkPriority(
+    webrtc::scoped_refptr<webrtc::RtpSenderInterface> sender) {
+  RTCNetworkPriority priority =
+      sender->media_type() == webrtc::MediaType::AUDIO
+          ? configuration_.audio_network_priority
+          : configuration_.video_network_priority;
+  if (!configuration_.enable_dscp || priority == RTCNetworkPriority::kLow)
+    return;
+
+  webrtc::RtpParameters parameters = sender->GetParameters();
+  for (webrtc::RtpEncodingParameters& encoding : parameters.encodings)
+    encoding.network_priority = ToNativePriority(priority);
+  webrtc::RTCError error = sender->SetParameters(parameters);
+  if (!error.ok()) {
+    RTC_LOG(LS_WARNING) << "Failed to set network priority: "
+                        << error.message();
+  }
+}
+
+static webrtc::PeerConnectionInterface::RTCOfferAnswerOptions
+ToNativeOfferAnswerOptions(const RTCOfferAnswerOptions& options) {
+  webrtc::PeerConnectionInterface::RTCOfferAnswerOptions native;
+  native.offer_to_receive_audio = options.offer_to_receive_audio;
+  native.offer_to_receive_video = options.offer_to_receive_video;
+  native.voice_activity_detection = options.voice_activity_detection;
+  native.ice_restart = options.ice_restart;
+  native.use_rtp_mux = options.use_rtp_mux;
+  native.raw_packetization_for_video = options.raw_packetization_for_video;
+  native.num_simulcast_layers = options.num_simulcast_layers;
+  return native;
+}
+
+// Batch window used instead of "until gathering completes" when gathering
+// is continual.
+static const int kContinualGatheringBatchWindowMs = 100;
+
+// The native SCTP receive window. Larger messages can't be reassembled, so
+// advertising them would only get the association aborted.
+static const uint32_t kNativeSctpReceiveWindow = 5 * 1024 * 1024;
+
 bool RTCPeerConnectionImpl::Initialize() {
   RTC_DCHECK(rtc_peerconnection_factory_.get() != nullptr);
   RTC_DCHECK(rtc_peerconnection_.get() == nullptr);
 
+  uint32_t receive_window = sctp_receive_window_ > 0
+                                ? sctp_receive_window_
+                                : kNativeSctpReceiveWindow;
+  sctp_max_message_size_ = configuration_.sctp_max_message_size;
+  if (sctp_max_message_size_ > receive_window) {
+    RTC_LOG(LS_WARNING) << "sctp_max_message_size " << sctp_max_message_size_
+                        << " exceeds the SCTP receive window, using "
+                        << receive_window;
+    sctp_max_message_size_ = receive_window;
+  }
+
   webrtc::PeerConnectionInterface::RTCConfiguration config;
   webrtc::PeerConnectionInterface::IceServers servers;
 
@@ -400,8 +715,16 @@ bool RTCPeerConnectionImpl::Initialize() {
   config.candidate_network_policy =
       webrtc::PeerConnectionInterface::kCandidateNetworkPolicyAll;
 
+  // Host candidates only, servers would add reflexive and relayed ones.
+  bool host_only = ice_lite_ || port_allocator_;
   for (int i = 0; i < kMaxIceServerSize; i++) {
     IceServer ice_server = configuration_.ice_servers[i];
+    if (host_only && ice_server.uri.size() > 0) {
+      RTC_LOG(LS_WARNING) << "Ignoring ICE server " << ice_server.uri.c_string()
+                          << ", connections on the shared UDP port or in "
+                             "ICE-lite mode gather host candidates only";
+      continue;
+    }
     if (ice_server.uri.size() > 0) {
       webrtc::PeerConnectionInterface::IceServer server;
       server.uri = to_std_string(ice_server.uri);
@@ -426,33 +749,76 @@ bool RTCPeerConnectionImpl::Initialize() {
 
   offer_answer_options_.use_rtp_mux = configuration_.use_rtp_mux;
 
-  // config.disable_ipv6 = configuration_.disable_ipv6;
   config.disable_ipv6_on_wifi = configuration_.disable_ipv6_on_wifi;
   config.disable_link_local_networks =
       configuration_.disable_link_local_networks;
-  config.max_ipv6_networks = configuration_.max_ipv6_networks;
+  // The native config has no disable_ipv6 any more, allowing no IPv6
+  // networks has the same effect on gathering.
+  config.max_ipv6_networks =
+      configuration_.disable_ipv6 ? 0 : configuration_.max_ipv6_networks;
+
+  ApplyIceTuning(configuration_, &config);
+
+  // Continual gathering never completes, candidates held until then would
+  // never be delivered.
+  candidate_batch_window_ms_ = configuration_.ice_candidate_batch_window_ms;
+  if (candidate_batch_window_ms_ < 0 &&
+      config.continual_gathering_policy ==
+          webrtc::PeerConnectionInterface::GATHER_CONTINUALLY) {
+    RTC_LOG(LS_WARNING) << "ice_candidate_batch_window_ms -1 needs gathering "
+                           "to complete, using "
+                        << kContinualGatheringBatchWindowMs << " ms";
+    candidate_batch_window_ms_ = kContinualGatheringBatchWindowMs;
+  }
+
+  if (configuration_.min_port > 0 && configuration_.max_port > 0) {
+    config.port_allocator_config.min_port = configuration_.min_port;
+    config.port_allocator_config.max_port = configuration_.max_port;
+  }
+
+  if (certificate_) config.certificates.push_back(certificate_);
 
   if (configuration_.screencast_min_bitrate > 0)
     config.screencast_min_bitrate = configuration_.screencast_min_bitrate;
 
+  config.set_dscp(configuration_.enable_dscp);
+  config.set_cpu_adaptation(configuration_.cpu_overuse_detection);
+  config.set_suspend_below_min_bitrate(
+      configuration_.suspend_below_min_bitrate);
+  if (configuration_.combined_audio_video_bwe)
+    config.combined_audio_video_bwe = true;
+
   RTCMediaConstraintsImpl* media_constraints =
       static_cast<RTCMediaConstraintsImpl*>(constraints_.get());
-  webrtc::MediaConstraints rtc_constraints(media_constraints->GetMandatory(),
-                                           media_constraints->GetOptional());
-  CopyConstraintsIntoRtcConfiguration(&rtc_constraints, &config);
+  if (media_constraints && (!media_constraints->GetMandatory().empty() ||
+                            !media_constraints->GetOptional().empty())) {
+    webrtc::MediaConstraints rtc_constraints(media_constraints->GetMandatory(),
+                                             media_constraints->GetOptional());
+    CopyConstraintsIntoRtcConfiguration(&rtc_constraints, &config);
+  }
 
   webrtc::PeerConnectionFactoryInterface::Options options;
   options.disable_encryption =
       (configuration_.srtp_type == MediaSecurityType::kSRTP_None);
-  // options.network_ignore_mask |= ADAPTER_TYPE_CELLULAR;
-  rtc_peerconnection_factory_->SetOptions(options);
-
-  webrtc::PeerConnectionDependencies dependencies(this);
-  auto result = rtc_peerconnection_factory_->CreatePeerConnectionOrError(
-      config, std::move(dependencies));
+  options.network_ignore_mask = configuration_.network_ignore_mask;
+
+  // The options are shared by every connection of the native factory and
+  // read when a connection is created. Both calls run as one signaling
+  // thread task, so concurrent Initialize() calls can't interleave and
+  // pick up each other's options.
+  auto result = signaling_thread_->BlockingCall([&] {
+    rtc_peerconnection_factory_->SetOptions(options);
+    webrtc::PeerConnectionDependencies dependencies(this);
+    if (port_allocator_) dependencies.allocator = std::move(port_allocator_);
+    return rtc_peerconnection_factory_->CreatePeerConnectionOrError(
+        config, std::move(dependencies));
+  });
 
   if (!result.ok()) {
-    RTC_LOG(LS_WARNING) << "CreatePeerConnection failed";
+    RTC_LOG(LS_WARNING) << "CreatePeerConnection failed: "
+                        << result.error().message();
+    initialize_error_type_ = ToRTCErrorType(result.error().type());
+    initialize_error_message_ = result.error().message();
     Close();
     return false;
   }
@@ -483,11 +849,15 @@ scoped_refptr<RTCDataChannel> RTCPeerConnectionImpl::CreateDataChannel(
     return nullptr;
   }
 
-  data_channel_ = scoped_refptr<RTCDataChannelImpl>(
-      new RefCountedObject<RTCDataChannelImpl>(result.MoveValue()));
+  scoped_refptr<RTCDataChannel> data_channel =
+      scoped_refptr<RTCDataChannelImpl>(
+          new RefCountedObject<RTCDataChannelImpl>(
+              result.MoveValue(), network_thread_,
+              data_channels_.CloseNotifier()));
+  data_channels_.Add(data_channel);
 
   dataChannelDict->id = init.id;
-  return data_channel_;
+  return data_channel;
 }
 
 void RTCPeerConnectionImpl::SetLocalDescription(const string sdp,
@@ -510,9 +880,29 @@ void RTCPeerConnectionImpl::SetLocalDescription(const string sdp,
     failure(error.c_str());
     return;
   }
+  ApplyLocalDescription(std::move(session_description), success, failure);
+}
+
+void RTCPeerConnectionImpl::SetLocalDescription(
+    scoped_refptr<RTCSessionDescription> description, OnSetSdpSuccess success,
+    OnSetSdpFailure failure) {
+  if (!description) {
+    failure("Session description is null.");
+    return;
+  }
+  RTCSessionDescriptionImpl* impl =
+      static_cast<RTCSessionDescriptionImpl*>(description.get());
+  ApplyLocalDescription(impl->description()->Clone(), success, failure);
+}
+
+void RTCPeerConnectionImpl::ApplyLocalDescription(
+    std::unique_ptr<webrtc::SessionDescriptionInterface> session_description,
+    OnSetSdpSuccess success, OnSetSdpFailure failure) {
+  scoped_refptr<RTCPeerConnectionImpl> self(this);
   webrtc::scoped_refptr<webrtc::SetLocalDescriptionObserverInterface> observer =
-      webrtc::make_ref_counted<SetSessionDescriptionObserverProxy>(success,
-                                                                   failure);
+      webrtc::make_ref_counted<SetSessionDescriptionObserverProxy>(
+          success, failure, setup_tracer_,
+          [self] { self->InvalidateDescriptionCache(); });
   rtc_peerconnection_->SetLocalDescription(std::move(session_description),
                                            observer);
 }
@@ -538,7 +928,26 @@ void RTCPeerConnectionImpl::SetRemoteDescription(const string sdp,
     failure(error.c_str());
     return;
   }
+  ApplyRemoteDescription(std::move(session_description), success, failure);
+}
+
+void RTCPeerConnectionImpl::SetRemoteDescription(
+    scoped_refptr<RTCSessionDescription> description, OnSetSdpSuccess success,
+    OnSetSdpFailure failure) {
+  if (!description) {
+    failure("Session description is null.");
+    return;
+  }
+  // The bandwidth rewrite below modifies the description, work on a copy so
+  // the shared handle stays untouched.
+  RTCSessionDescriptionImpl* impl =
+      static_cast<RTCSessionDescriptionImpl*>(description.get());
+  ApplyRemoteDescription(impl->description()->Clone(), success, failure);
+}
 
+void RTCPeerConnectionImpl::ApplyRemoteDescription(
+    std::unique_ptr<webrtc::SessionDescriptionInterface> session_description,
+    OnSetSdpSuccess success, OnSetSdpFailure failure) {
   webrtc::MediaContentDescription* content_desc =
       session_description->description()->GetContentDescriptionByName("video");
   webrtc::MediaContentDescription* media_content_desc =
@@ -547,50 +956,82 @@ void RTCPeerConnectionImpl::SetRemoteDescription(const string sdp,
   if (media_content_desc && configuration_.local_video_bandwidth > 0)
     media_content_desc->set_bandwidth(configuration_.local_video_bandwidth *
                                       1000);
+  scoped_refptr<RTCPeerConnectionImpl> self(this);
   webrtc::scoped_refptr<webrtc::SetRemoteDescriptionObserverInterface>
       observer = webrtc::make_ref_counted<SetSessionDescriptionObserverProxy>(
-          success, failure);
+          success, failure, setup_tracer_,
+          [self] { self->InvalidateDescriptionCache(); });
   rtc_peerconnection_->SetRemoteDescription(std::move(session_description),
                                             observer);
+}
 
-  return;
+void RTCPeerConnectionImpl::InvalidateDescriptionCache() {
+  webrtc::MutexLock lock(&description_cache_mutex_);
+  description_version_++;
+}
+
+bool RTCPeerConnectionImpl::SerializeDescription(bool local, std::string* sdp,
+                                                 std::string* type) {
+  DescriptionCache* cache =
+      local ? &local_description_cache_ : &remote_description_cache_;
+  uint64_t version = 0;
+  {
+    webrtc::MutexLock lock(&description_cache_mutex_);
+    if (cache->version == description_version_) {
+      *sdp = cache->sdp;
+      *type = cache->type;
+      return true;
+    }
+    version = description_version_;
+  }
+
+  if (!rtc_peerconnection_) return false;
+  const webrtc::SessionDescriptionInterface* description =
+      local ? rtc_peerconnection_->local_description()
+            : rtc_peerconnection_->remote_description();
+  if (!description) return false;
+  description->ToString(sdp);
+  *type = webrtc::SdpTypeToString(description->GetType());
+
+  // Only keep the result if nothing changed while serializing.
+  webrtc::MutexLock lock(&description_cache_mutex_);
+  if (version == description_version_) {
+    cache->version = version;
+    cache->sdp = *sdp;
+    cache->type = *type;
+  }
+  return true;
 }
 
 void RTCPeerConnectionImpl::GetLocalDescription(OnGetSdpSuccess success,
                                                 OnGetSdpFailure failure) {
-  auto local_description = rtc_peerconnection_->local_description();
-  if (!local_description) {
+  std::string sdp;
+  std::string type;
+  if (!SerializeDescription(true, &sdp, &type)) {
     if (failure) {
       failure("not local description");
     }
     return;
   }
 
-  if (success) {
-    std::string dsp;
-    local_description->ToString(&dsp);
-    success(dsp.c_str(), webrtc::SdpTypeToString(local_description->GetType()));
-  }
+  if (success) success(sdp.c_str(), type.c_str());
 }
 
 void RTCPeerConnectionImpl::GetRemoteDescription(OnGetSdpSuccess success,
                                                  OnGetSdpFailure failure) {
-  auto remote_description = rtc_peerconnection_->remote_description();
-  if (!remote_description) {
+  std::string sdp;
+  std::string type;
+  if (!SerializeDescription(false, &sdp, &type)) {
     if (failure) {
       failure("not remote description");
     }
     return;
   }
 
-  if (success) {
-    std::string dsp;
-    remote_description->ToString(&dsp);
-    success(dsp.c_str(),
-            webrtc::SdpTypeToString(remote_description->GetType()));
-  }
+  if (success) success(sdp.c_str(), type.c_str());
 }
 
+
 void RTCPeerConnectionImpl::CreateOffer(
     OnSdpCreateSuccess success, OnSdpCreateFailure failure,
     scoped_refptr<RTCMediaConstraints> constraints) {
@@ -600,19 +1041,11 @@ void RTCPeerConnectionImpl::CreateOffer(
     return;
   }
 
-  RTCMediaConstraintsImpl* media_constraints =
-      static_cast<RTCMediaConstraintsImpl*>(constraints.get());
-  webrtc::PeerConnectionInterface::RTCOfferAnswerOptions offer_answer_options;
-  webrtc::MediaConstraints rtc_constraints(media_constraints->GetMandatory(),
-                                           media_constraints->GetOptional());
-  if (CopyConstraintsIntoOfferAnswerOptions(&rtc_constraints,
-                                            &offer_answer_options) == false) {
-    offer_answer_options = offer_answer_options_;
-  }
-
   rtc_peerconnection_->CreateOffer(
-      CreateSessionDescriptionObserverProxy::Create(success, failure),
-      offer_answer_options);
+      CreateSessionDescriptionObserverProxy::Create(
+          success, failure, sctp_max_message_size_, ice_lite_,
+          setup_tracer_),
+      OfferAnswerOptions(constraints));
 }
 
 void RTCPeerConnectionImpl::CreateAnswer(
@@ -623,8 +1056,53 @@ void RTCPeerConnectionImpl::CreateAnswer(
     failure("Failed to initialize PeerConnection");
     return;
   }
+  rtc_peerconnection_->CreateAnswer(
+      CreateSessionDescriptionObserverProxy::Create(
+          success, failure, sctp_max_message_size_, ice_lite_,
+          setup_tracer_),
+      OfferAnswerOptions(constraints));
+}
+
+void RTCPeerConnectionImpl::CreateOffer(OnSdpCreateSuccess success,
+                                        OnSdpCreateFailure failure,
+                                        const RTCOfferAnswerOptions& options) {
+  if (!rtc_peerconnection_.get() || !rtc_peerconnection_factory_.get()) {
+    webrtc::MutexLock cs(callback_crt_sec_.get());
+    failure("Failed to initialize PeerConnection");
+    return;
+  }
+  rtc_peerconnection_->CreateOffer(
+      CreateSessionDescriptionObserverProxy::Create(
+          success, failure, sctp_max_message_size_, ice_lite_,
+          setup_tracer_),
+      ToNativeOfferAnswerOptions(options));
+}
+
+void RTCPeerConnectionImpl::CreateAnswer(OnSdpCreateSuccess success,
+                                         OnSdpCreateFailure failure,
+                                         const RTCOfferAnswerOptions& options) {
+  if (!rtc_peerconnection_.get() || !rtc_peerconnection_factory_.get()) {
+    webrtc::MutexLock cs(callback_crt_sec_.get());
+    failure("Failed to initialize PeerConnection");
+    return;
+  }
+  rtc_peerconnection_->CreateAnswer(
+      CreateSessionDescriptionObserverProxy::Create(
+          success, failure, sctp_max_message_size_, ice_lite_,
+          setup_tracer_),
+      ToNativeOfferAnswerOptions(options));
+}
+
+webrtc::PeerConnectionInterface::RTCOfferAnswerOptions
+RTCPeerConnectionImpl::OfferAnswerOptions(
+    scoped_refptr<RTCMediaConstraints> constraints) {
   RTCMediaConstraintsImpl* media_constraints =
       static_cast<RTCMediaConstraintsImpl*>(constraints.get());
+  // Without constraints the conversion below yields the defaults, skip it.
+  if (!media_constraints || (media_constraints->GetMandatory().empty() &&
+                             media_constraints->GetOptional().empty()))
+    return webrtc::PeerConnectionInterface::RTCOfferAnswerOptions();
+
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions offer_answer_options;
   webrtc::MediaConstraints rtc_constraints(media_constraints->GetMandatory(),
                                            media_constraints->GetOptional());
@@ -632,9 +1110,23 @@ void RTCPeerConnectionImpl::CreateAnswer(
                                             &offer_answer_options) == false) {
     offer_answer_options = offer_answer_options_;
   }
-  rtc_peerconnection_->CreateAnswer(
-      CreateSessionDescriptionObserverProxy::Create(success, failure),
-      offer_answer_options);
+  return offer_answer_options;
+}
+
+RTCErrorType RTCPeerConnectionImpl::SetBitrate(
+    const RTCBitrateSettings& settings) {
+  if (!rtc_peerconnection_) return RTCErrorType::kInvalidState;
+  webrtc::BitrateSettings bitrate;
+  if (settings.min_bitrate_bps >= 0)
+    bitrate.min_bitrate_bps = settings.min_bitrate_bps;
+  if (settings.start_bitrate_bps >= 0)
+    bitrate.start_bitrate_bps = settings.start_bitrate_bps;
+  if (settings.max_bitrate_bps >= 0)
+    bitrate.max_bitrate_bps = settings.max_bitrate_bps;
+  webrtc::RTCError error = rtc_peerconnection_->SetBitrate(bitrate);
+  if (!error.ok())
+    RTC_LOG(LS_WARNING) << "SetBitrate failed: " << error.message();
+  return ToRTCErrorType(error.type());
 }
 
 void RTCPeerConnectionImpl::RestartIce() {
@@ -648,7 +1140,7 @@ void RTCPeerConnectionImpl::Close() {
   RTC_LOG(LS_INFO) << __FUNCTION__;
   if (rtc_peerconnection_.get()) {
     rtc_peerconnection_ = nullptr;
-    data_channel_ = nullptr;
+    data_channels_.Clear();
     local_streams_.clear();
     for (auto stream : remote_streams_) {
       if (observer_) {
@@ -777,6 +1269,7 @@ scoped_refptr<RTCRtpTransceiver> RTCPeerConnectionImpl::AddTransceiver(
   }
 
   if (errorOr.ok()) {
+    ApplyNetworkPriority(errorOr.value()->sender());
     return new RefCountedObject<RTCRtpTransceiverImpl>(errorOr.value());
   }
 
@@ -797,6 +1290,7 @@ scoped_refptr<RTCRtpTransceiver> RTCPeerConnectionImpl::AddTransceiver(
   }
 
   if (errorOr.ok()) {
+    ApplyNetworkPriority(errorOr.value()->sender());
     return new RefCountedObject<RTCRtpTransceiverImpl>(errorOr.value());
   }
   // onAdd(scoped_refptr<RTCRtpTransceiver>(), errorOr.error().message());
@@ -813,6 +1307,7 @@ scoped_refptr<RTCRtpTransceiver> RTCPeerConnectionImpl::AddTransceiver(
     errorOr = rtc_peerconnection_->AddTransceiver(webrtc::MediaType::VIDEO);
   }
   if (errorOr.ok()) {
+    ApplyNetworkPriority(errorOr.value()->sender());
     return new RefCountedObject<RTCRtpTransceiverImpl>(errorOr.value());
   }
   // onAdd(scoped_refptr<RTCRtpTransceiver>(), errorOr.error().message());
@@ -833,6 +1328,7 @@ scoped_refptr<RTCRtpTransceiver> RTCPeerConnectionImpl::AddTransceiver(
         webrtc::MediaType::VIDEO, initImpl->rtp_transceiver_init());
   }
   if (errorOr.ok()) {
+    ApplyNetworkPriority(errorOr.value()->sender());
     return new RefCountedObject<RTCRtpTransceiverImpl>(errorOr.value());
   }
   // onAdd(scoped_refptr<RTCRtpTransceiver>(), errorOr.error().message());
@@ -857,6 +1353,7 @@ scoped_refptr<RTCRtpSender> RTCPeerConnectionImpl::AddTrack(
   }
 
   if (errorOr.ok()) {
+    ApplyNetworkPriority(errorOr.value());
     return new RefCountedObject<RTCRtpSenderImpl>(errorOr.value());
   }
 
@@ -921,6 +1418,10 @@ RTCIceGatheringState RTCPeerConnectionImpl::ice_gathering_state() {
   return ice_gathering_state_map[rtc_peerconnection_->ice_gathering_state()];
 }
 
+RTCSetupTimeline RTCPeerConnectionImpl::setup_timeline() {
+  return setup_tracer_ ? setup_tracer_->timeline() : RTCSetupTimeline();
+}
+
 void WebRTCStatsCollectorCallback::OnStatsDelivered(
     const webrtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
   webrtc::RTCStatsReport::ConstIterator iter = report->begin();
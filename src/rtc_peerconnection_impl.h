@@ -3,14 +3,19 @@
 
 #include <deque>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
+#include "api/candidate.h"
 #include "api/data_channel_interface.h"
 #include "api/media_stream_interface.h"
 #include "api/peer_connection_interface.h"
 #include "api/scoped_refptr.h"
+#include "p2p/base/port_allocator.h"
 #include "modules/video_capture/video_capture.h"
+#include "rtc_base/rtc_certificate.h"
 #include "rtc_audio_track_impl.h"
 #include "rtc_base/synchronization/mutex.h"
 #include "rtc_peerconnection.h"
@@ -19,6 +24,8 @@
 #include "rtc_video_source.h"
 #include "rtc_video_source_impl.h"
 #include "rtc_video_track_impl.h"
+#include "src/internal/data_channel_registry.h"
+#include "src/internal/setup_tracer.h"
 #include "src/internal/video_capturer.h"
 
 namespace webrtc {
@@ -44,6 +51,14 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
       OnSdpCreateSuccess success, OnSdpCreateFailure failure,
       scoped_refptr<RTCMediaConstraints> constraints) override;
 
+  virtual void CreateOffer(OnSdpCreateSuccess success,
+                           OnSdpCreateFailure failure,
+                           const RTCOfferAnswerOptions& options) override;
+
+  virtual void CreateAnswer(OnSdpCreateSuccess success,
+                            OnSdpCreateFailure failure,
+                            const RTCOfferAnswerOptions& options) override;
+
   virtual void SetLocalDescription(const string sdp, const string type,
                                    OnSetSdpSuccess success,
                                    OnSetSdpFailure failure) override;
@@ -52,6 +67,14 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
                                     OnSetSdpSuccess success,
                                     OnSetSdpFailure failure) override;
 
+  virtual void SetLocalDescription(
+      scoped_refptr<RTCSessionDescription> description,
+      OnSetSdpSuccess success, OnSetSdpFailure failure) override;
+
+  virtual void SetRemoteDescription(
+      scoped_refptr<RTCSessionDescription> description,
+      OnSetSdpSuccess success, OnSetSdpFailure failure) override;
+
   virtual void GetLocalDescription(OnGetSdpSuccess success,
                                    OnGetSdpFailure failure) override;
 
@@ -61,8 +84,13 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
   virtual void AddCandidate(const string mid, int midx,
                             const string candiate) override;
 
+  virtual void AddCandidates(const vector<RTCIceCandidateInit> candidates,
+                             OnAddCandidatesComplete callback) override;
+
   virtual void RestartIce() override;
 
+  virtual RTCErrorType SetBitrate(const RTCBitrateSettings& settings) override;
+
   virtual void Close() override;
 
   virtual void RegisterRTCPeerConnectionObserver(
@@ -121,9 +149,30 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
 
   virtual RTCIceGatheringState ice_gathering_state() override;
 
+  virtual RTCSetupTimeline setup_timeline() override;
+
   virtual scoped_refptr<RTCDataChannel> CreateDataChannel(
       const string label, RTCDataChannelInit* dataChannelDict) override;
 
+  virtual scoped_refptr<RTCDataChannel> GetDataChannelById(int id) override {
+    return data_channels_.FindById(id);
+  }
+
+  virtual scoped_refptr<RTCDataChannel> GetDataChannelByLabel(
+      const string label) override {
+    return data_channels_.FindByLabel(label.std_string());
+  }
+
+  virtual vector<scoped_refptr<RTCDataChannel>> data_channels() override {
+    return data_channels_.List();
+  }
+
+  virtual void CloseDataChannels() override { data_channels_.CloseAll(); }
+
+  virtual RTCDataChannelTrafficStats data_channel_traffic_stats() override {
+    return data_channels_.TrafficStats();
+  }
+
   virtual bool GetStats(scoped_refptr<RTCRtpSender> sender,
                         OnStatsCollectorSuccess success,
                         OnStatsCollectorFailure failure) override;
@@ -140,7 +189,21 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
       const RTCConfiguration& configuration,
       scoped_refptr<RTCMediaConstraints> constraints,
       webrtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
-          peer_connection_factory);
+          peer_connection_factory,
+      webrtc::Thread* network_thread, webrtc::Thread* signaling_thread,
+      const RTCPeerConnectionFactoryOptions& factory_options,
+      webrtc::scoped_refptr<webrtc::RTCCertificate> certificate = nullptr,
+      std::unique_ptr<webrtc::PortAllocator> port_allocator = nullptr);
+
+  // nullptr unless RTCConfiguration::trace_connection_setup is set.
+  std::shared_ptr<SetupTracer> setup_tracer() { return setup_tracer_; }
+
+  // Why Initialize() failed, kNone if it succeeded.
+  RTCErrorType initialize_error_type() const { return initialize_error_type_; }
+
+  const std::string& initialize_error_message() const {
+    return initialize_error_message_;
+  }
 
  protected:
   ~RTCPeerConnectionImpl();
@@ -173,6 +236,9 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
   virtual void OnIceCandidate(
       const webrtc::IceCandidateInterface* candidate) override;
 
+  virtual void OnIceCandidatesRemoved(
+      const std::vector<webrtc::Candidate>& candidates) override;
+
   virtual void OnIceGatheringChange(
       webrtc::PeerConnectionInterface::IceGatheringState new_state) override;
 
@@ -182,11 +248,58 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
   virtual void OnSignalingChange(
       webrtc::PeerConnectionInterface::SignalingState new_state) override;
 
+  // Delivers the coalesced local candidates to the observer.
+  void FlushIceCandidates();
+
+  void MarkSetupMilestone(RTCSetupMilestone milestone);
+
+  // Sets the configured per media type network priority (DSCP) on |sender|.
+  void ApplyNetworkPriority(
+      webrtc::scoped_refptr<webrtc::RtpSenderInterface> sender);
+
+  // Converts |constraints|, falls back to the options derived from the
+  // configuration if a mandatory constraint is not understood.
+  webrtc::PeerConnectionInterface::RTCOfferAnswerOptions OfferAnswerOptions(
+      scoped_refptr<RTCMediaConstraints> constraints);
+
+  void ApplyLocalDescription(
+      std::unique_ptr<webrtc::SessionDescriptionInterface> description,
+      OnSetSdpSuccess success, OnSetSdpFailure failure);
+
+  void ApplyRemoteDescription(
+      std::unique_ptr<webrtc::SessionDescriptionInterface> description,
+      OnSetSdpSuccess success, OnSetSdpFailure failure);
+
+  // Drops the strings cached by Get{Local,Remote}Description(). Called
+  // whenever a description or its candidates may have changed.
+  void InvalidateDescriptionCache();
+
+  bool SerializeDescription(bool local, std::string* sdp, std::string* type);
+
+  // Probes stats until the media milestones are reached or the probe times
+  // out.
+  void ProbeMediaMilestones();
+
  protected:
   webrtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
       rtc_peerconnection_factory_;
   webrtc::scoped_refptr<webrtc::PeerConnectionInterface> rtc_peerconnection_;
-  const RTCConfiguration& configuration_;
+  webrtc::Thread* network_thread_ = nullptr;
+  webrtc::Thread* signaling_thread_ = nullptr;
+  // Kept as the caller passed it, the factory pool compares against it.
+  const RTCConfiguration configuration_;
+  // |configuration_.sctp_max_message_size| clamped to the receive window.
+  uint32_t sctp_max_message_size_ = 0;
+  // RTCPeerConnectionFactoryOptions::sctp_receive_window, 0 if native.
+  uint32_t sctp_receive_window_ = 0;
+  // Pre-generated DTLS certificate, nullptr lets the native connection
+  // generate its own.
+  webrtc::scoped_refptr<webrtc::RTCCertificate> certificate_;
+  // Allocator on the factory's shared UDP port, handed to the native
+  // connection by Initialize(). nullptr uses the native one.
+  std::unique_ptr<webrtc::PortAllocator> port_allocator_;
+  // RTCPeerConnectionFactoryOptions::ice_lite.
+  bool ice_lite_ = false;
   scoped_refptr<RTCMediaConstraints> constraints_;
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions offer_answer_options_;
   RTCPeerConnectionObserver* observer_ = nullptr;
@@ -194,9 +307,36 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
   bool initialize_offer_sent = false;
   std::vector<scoped_refptr<RTCMediaStream>> local_streams_;
   std::vector<scoped_refptr<RTCMediaStream>> remote_streams_;
-  scoped_refptr<RTCDataChannel> data_channel_;
+  DataChannelRegistry data_channels_;
+  // Coalesced local candidates, only touched on the signaling thread.
+  std::vector<scoped_refptr<RTCIceCandidate>> pending_candidates_;
+  bool candidate_flush_scheduled_ = false;
+  // Effective |configuration_.ice_candidate_batch_window_ms|.
+  int candidate_batch_window_ms_ = 0;
+  std::shared_ptr<SetupTracer> setup_tracer_;
+
+  struct DescriptionCache {
+    // Valid while equal to |description_version_|.
+    uint64_t version = 0;
+    std::string sdp;
+    std::string type;
+  };
+  webrtc::Mutex description_cache_mutex_;
+  uint64_t description_version_ = 1;
+  DescriptionCache local_description_cache_;
+  DescriptionCache remote_description_cache_;
+  RTCErrorType initialize_error_type_ = RTCErrorType::kNone;
+  std::string initialize_error_message_;
 };
 
+inline RTCErrorType ToRTCErrorType(webrtc::RTCErrorType type) {
+  static_assert(static_cast<int>(RTCErrorType::kOperationErrorWithData) ==
+                    static_cast<int>(
+                        webrtc::RTCErrorType::OPERATION_ERROR_WITH_DATA),
+                "RTCErrorType must mirror webrtc::RTCErrorType");
+  return static_cast<RTCErrorType>(type);
+}
+
 }  // namespace libwebrtc
 
 #endif  // LIB_WEBRTC_MEDIA_SESSION_IMPL_HXX
@@ -5,6 +5,7 @@
 #include <src/rtc_dtmf_sender_impl.h>
 #include <src/rtc_rtp_parameters_impl.h>
 #include <src/rtc_video_track_impl.h>
+#include "rtc_base/logging.h"
 
 namespace libwebrtc {
 RTCRtpSenderImpl::RTCRtpSenderImpl(
@@ -102,6 +103,25 @@ bool RTCRtpSenderImpl::set_parameters(
   return rtp_sender_->SetParameters(impl->rtp_parameters()).ok();
 }
 
+bool RTCRtpSenderImpl::SetBitrate(const RTCRtpSenderBitrate& bitrate) {
+  webrtc::RtpParameters parameters = rtp_sender_->GetParameters();
+  for (webrtc::RtpEncodingParameters& encoding : parameters.encodings) {
+    if (bitrate.min_bitrate_bps >= 0)
+      encoding.min_bitrate_bps = bitrate.min_bitrate_bps;
+    else
+      encoding.min_bitrate_bps.reset();
+    if (bitrate.max_bitrate_bps >= 0)
+      encoding.max_bitrate_bps = bitrate.max_bitrate_bps;
+    else
+      encoding.max_bitrate_bps.reset();
+    encoding.bitrate_priority = bitrate.bitrate_priority;
+  }
+  webrtc::RTCError error = rtp_sender_->SetParameters(parameters);
+  if (!error.ok())
+    RTC_LOG(LS_WARNING) << "SetBitrate failed: " << error.message();
+  return error.ok();
+}
+
 scoped_refptr<RTCDtmfSender> RTCRtpSenderImpl::dtmf_sender() const {
   if (nullptr == rtp_sender_->GetDtmfSender().get()) {
     return scoped_refptr<RTCDtmfSender>();
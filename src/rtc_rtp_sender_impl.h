@@ -25,6 +25,7 @@ class RTCRtpSenderImpl : public RTCRtpSender {
   virtual bool set_parameters(
       const scoped_refptr<RTCRtpParameters> parameters) override;
   virtual scoped_refptr<RTCDtmfSender> dtmf_sender() const override;
+  virtual bool SetBitrate(const RTCRtpSenderBitrate& bitrate) override;
 
   webrtc::scoped_refptr<webrtc::RtpSenderInterface> rtc_rtp_sender() {
     return rtp_sender_;
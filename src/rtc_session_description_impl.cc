@@ -29,11 +29,13 @@ RTCSessionDescriptionImpl::RTCSessionDescriptionImpl(
     std::unique_ptr<webrtc::SessionDescriptionInterface> description)
     : description_(std::move(description)) {}
 
-const string RTCSessionDescriptionImpl::sdp() const {
-  description_->ToString((std::string*)&sdp_);
+const std::string& RTCSessionDescriptionImpl::Serialized() const {
+  std::call_once(sdp_once_, [this] { description_->ToString(&sdp_); });
   return sdp_;
 }
 
+const string RTCSessionDescriptionImpl::sdp() const { return Serialized(); }
+
 RTCSessionDescription::SdpType RTCSessionDescriptionImpl::GetType() {
   return (RTCSessionDescription::SdpType)description_->GetType();
 }
@@ -44,12 +46,15 @@ const string RTCSessionDescriptionImpl::type() {
 }
 
 bool RTCSessionDescriptionImpl::ToString(string& out) {
-  std::string tmp;
-  if (description_->ToString(&tmp)) {
-    out = tmp;
-    return true;
-  }
-  return false;
+  const std::string& sdp = Serialized();
+  if (sdp.empty()) return false;
+  out = sdp;
+  return true;
+}
+
+scoped_refptr<RTCSessionDescription> RTCSessionDescriptionImpl::Clone() {
+  return scoped_refptr<RTCSessionDescriptionImpl>(
+      new RefCountedObject<RTCSessionDescriptionImpl>(description_->Clone()));
 }
 
 }  // namespace libwebrtc
\ No newline at end of file
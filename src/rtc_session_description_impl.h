@@ -1,5 +1,7 @@
 #ifndef LIB_WEBRTC_RTC_SESSION_DESCRIPTION_IMPL_HXX
 #define LIB_WEBRTC_RTC_SESSION_DESCRIPTION_IMPL_HXX
+#include <mutex>
+
 #include "api/jsep.h"
 #include "rtc_session_description.h"
 #include "rtc_types.h"
@@ -20,13 +22,20 @@ class RTCSessionDescriptionImpl : public RTCSessionDescription {
 
   virtual bool ToString(string& out) override;
 
+  virtual scoped_refptr<RTCSessionDescription> Clone() override;
+
   webrtc::SessionDescriptionInterface* description() {
     return description_.get();
   }
 
+ private:
+  const std::string& Serialized() const;
+
  private:
   std::unique_ptr<webrtc::SessionDescriptionInterface> description_;
-  std::string sdp_;
+  // Serialized once on first use, the description does not change.
+  mutable std::once_flag sdp_once_;
+  mutable std::string sdp_;
   std::string type_;
 };
 
@@ -52,4 +52,22 @@ scoped_refptr<RTCVideoCapturer> RTCVideoDeviceImpl::Create(const char* name,
   });
 }
 
+void RTCVideoDeviceImpl::CreateAsync(const char* name, uint32_t index,
+                                     size_t width, size_t height,
+                                     size_t target_fps,
+                                     OnCapturerCreated callback) {
+  scoped_refptr<RTCVideoDeviceImpl> self(this);
+  worker_thread_->PostTask(
+      [self, index, width, height, target_fps, callback]() mutable {
+        auto vcm = webrtc::internal::VcmCapturer::Create(
+            self->worker_thread_, width, height, target_fps, index);
+        if (vcm == nullptr) {
+          callback(nullptr);
+          return;
+        }
+        callback(scoped_refptr<RTCVideoCapturerImpl>(
+            new RefCountedObject<RTCVideoCapturerImpl>(vcm)));
+      });
+}
+
 }  // namespace libwebrtc
@@ -53,6 +53,10 @@ class RTCVideoDeviceImpl : public RTCVideoDevice {
                                          size_t width, size_t height,
                                          size_t target_fps) override;
 
+  void CreateAsync(const char* name, uint32_t index, size_t width,
+                   size_t height, size_t target_fps,
+                   OnCapturerCreated callback) override;
+
  private:
   std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> device_info_;
   webrtc::Thread* worker_thread_ = nullptr;
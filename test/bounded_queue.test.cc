@@ -0,0 +1,76 @@
+#include <memory>
+#include <thread>
+
+#include "libwebrtc_test.h"
+#include "src/internal/bounded_queue.h"
+
+using libwebrtc::BoundedQueue;
+
+TEST(BoundedQueue, StartsEmpty) {
+  BoundedQueue<int> queue(4);
+  int value = -1;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.size(), 0u);
+  EXPECT_EQ(queue.capacity(), 4u);
+  EXPECT_FALSE(queue.Pop(&value));
+  EXPECT_EQ(value, -1);
+}
+
+TEST(BoundedQueue, RejectsPushWhenFull) {
+  BoundedQueue<std::unique_ptr<int>> queue(2);
+  EXPECT_TRUE(queue.Push(std::make_unique<int>(1)));
+  EXPECT_TRUE(queue.Push(std::make_unique<int>(2)));
+  std::unique_ptr<int> rejected = std::make_unique<int>(3);
+  EXPECT_FALSE(queue.Push(std::move(rejected)));
+  // A rejected value is left with the caller.
+  EXPECT_TRUE(rejected && *rejected == 3);
+  EXPECT_EQ(queue.size(), 2u);
+}
+
+TEST(BoundedQueue, ZeroCapacityHoldsOne) {
+  BoundedQueue<int> queue(0);
+  EXPECT_EQ(queue.capacity(), 1u);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_FALSE(queue.Push(2));
+}
+
+TEST(BoundedQueue, WrapsAroundInOrder) {
+  BoundedQueue<int> queue(3);
+  int next_push = 0;
+  int next_pop = 0;
+  for (int round = 0; round < 10; round++) {
+    while (queue.Push(int(next_push))) next_push++;
+    EXPECT_EQ(queue.size(), 3u);
+    int value = -1;
+    EXPECT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(value, next_pop++);
+    EXPECT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(value, next_pop++);
+    EXPECT_EQ(queue.size(), 1u);
+  }
+  int value = -1;
+  while (queue.Pop(&value)) EXPECT_EQ(value, next_pop++);
+  EXPECT_EQ(next_pop, next_push);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(BoundedQueue, SingleProducerSingleConsumer) {
+  const int kCount = 100000;
+  BoundedQueue<int> queue(64);
+  std::thread producer([&queue] {
+    for (int i = 0; i < kCount;) {
+      if (queue.Push(int(i))) i++;
+    }
+  });
+  int expected = 0;
+  bool in_order = true;
+  while (expected < kCount) {
+    int value = 0;
+    if (!queue.Pop(&value)) continue;
+    if (value != expected) in_order = false;
+    expected++;
+  }
+  producer.join();
+  EXPECT_TRUE(in_order);
+  EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,70 @@
+#include "libwebrtc_test.h"
+#include "src/internal/buffered_amount_watermark.h"
+
+using libwebrtc::BufferedAmountWatermark;
+
+TEST(BufferedAmountWatermark, FiresOnDownwardCrossing) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  EXPECT_FALSE(watermark.Update(500));
+  EXPECT_TRUE(watermark.Update(100));
+  EXPECT_FALSE(watermark.Update(50));
+}
+
+TEST(BufferedAmountWatermark, FiresWhenDropSpansSeveralUpdates) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  watermark.Update(400);
+  EXPECT_FALSE(watermark.Update(300));
+  EXPECT_FALSE(watermark.Update(200));
+  EXPECT_TRUE(watermark.Update(0));
+}
+
+TEST(BufferedAmountWatermark, FiresOncePerCrossing) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  watermark.Update(200);
+  EXPECT_TRUE(watermark.Update(10));
+  EXPECT_FALSE(watermark.Update(10));
+  watermark.Update(150);
+  EXPECT_TRUE(watermark.Update(90));
+}
+
+TEST(BufferedAmountWatermark, FiresForSingleSendThatCrossedAndDrained) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  // A 500 byte send went out without an update in between, the callback
+  // reports it drained completely.
+  EXPECT_TRUE(watermark.Update(0, 500));
+  EXPECT_FALSE(watermark.Update(0, 50));
+}
+
+TEST(BufferedAmountWatermark, SingleSendStayingBelowNeverFires) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  EXPECT_FALSE(watermark.Update(0, 100));
+  EXPECT_FALSE(watermark.Update(20, 60));
+}
+
+TEST(BufferedAmountWatermark, IgnoresRises) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  EXPECT_FALSE(watermark.Update(50));
+  EXPECT_FALSE(watermark.Update(150));
+}
+
+TEST(BufferedAmountWatermark, FiresWhenThresholdRaisedAboveAmount) {
+  BufferedAmountWatermark watermark;
+  watermark.SetThreshold(100);
+  watermark.Update(300);
+  EXPECT_FALSE(watermark.SetThreshold(200));
+  EXPECT_TRUE(watermark.SetThreshold(300));
+  EXPECT_FALSE(watermark.SetThreshold(400));
+  EXPECT_FALSE(watermark.Update(250));
+}
+
+TEST(BufferedAmountWatermark, NothingBufferedNeverFires) {
+  BufferedAmountWatermark watermark;
+  EXPECT_FALSE(watermark.SetThreshold(100));
+  EXPECT_FALSE(watermark.Update(0));
+}
@@ -0,0 +1,51 @@
+#include <string>
+#include <vector>
+
+#include "libwebrtc_test.h"
+#include "src/internal/constraint_list.h"
+
+using libwebrtc::SameConstraintList;
+
+namespace {
+
+struct Constraint {
+  std::string key;
+  std::string value;
+};
+
+typedef std::vector<Constraint> Constraints;
+
+}  // namespace
+
+TEST(ConstraintList, NullEqualsEmpty) {
+  Constraints empty;
+  EXPECT_TRUE(SameConstraintList<Constraints>(nullptr, nullptr));
+  EXPECT_TRUE(SameConstraintList<Constraints>(nullptr, &empty));
+  EXPECT_TRUE(SameConstraintList<Constraints>(&empty, nullptr));
+}
+
+TEST(ConstraintList, NullDiffersFromNonEmpty) {
+  Constraints one = {{"DtlsSrtpKeyAgreement", "true"}};
+  EXPECT_FALSE(SameConstraintList<Constraints>(nullptr, &one));
+  EXPECT_FALSE(SameConstraintList<Constraints>(&one, nullptr));
+}
+
+TEST(ConstraintList, ComparesKeysAndValues) {
+  Constraints a = {{"googIPv6", "true"}, {"googDscp", "false"}};
+  Constraints b = a;
+  EXPECT_TRUE(SameConstraintList(&a, &b));
+  b[1].value = "true";
+  EXPECT_FALSE(SameConstraintList(&a, &b));
+  b = a;
+  b[0].key = "googIPv4";
+  EXPECT_FALSE(SameConstraintList(&a, &b));
+  b = a;
+  b.pop_back();
+  EXPECT_FALSE(SameConstraintList(&a, &b));
+}
+
+TEST(ConstraintList, OrderMatters) {
+  Constraints a = {{"googIPv6", "true"}, {"googDscp", "false"}};
+  Constraints b = {{"googDscp", "false"}, {"googIPv6", "true"}};
+  EXPECT_FALSE(SameConstraintList(&a, &b));
+}
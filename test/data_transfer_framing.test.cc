@@ -0,0 +1,94 @@
+#include <stdint.h>
+
+#include <vector>
+
+#include "libwebrtc_test.h"
+#include "src/internal/data_transfer_framing.h"
+
+using namespace libwebrtc;
+
+namespace {
+
+std::vector<uint8_t> Frame(uint8_t kind, uint32_t id, uint64_t value,
+                           size_t payload_size) {
+  std::vector<uint8_t> frame(kTransferChunkHeaderSize + payload_size, 0xab);
+  frame[0] = kind;
+  WriteTransferUint32(frame.data() + 1, id);
+  WriteTransferUint64(frame.data() + kTransferControlHeaderSize, value);
+  return frame;
+}
+
+}  // namespace
+
+TEST(DataTransferFraming, ParsesChunk) {
+  std::vector<uint8_t> data = Frame(kTransferChunk, 7, 1000, 16);
+  TransferFrame frame;
+  EXPECT_TRUE(ParseTransferFrame(data.data(), data.size(), &frame));
+  EXPECT_EQ(frame.kind, kTransferChunk);
+  EXPECT_EQ(frame.id, 7u);
+  EXPECT_EQ(frame.value, 1000u);
+  EXPECT_EQ(frame.payload_size, 16u);
+  EXPECT_TRUE(frame.payload == data.data() + kTransferChunkHeaderSize);
+}
+
+TEST(DataTransferFraming, ParsesBeginName) {
+  std::vector<uint8_t> data = Frame(kTransferBegin, 3, 1 << 20, 4);
+  TransferFrame frame;
+  EXPECT_TRUE(ParseTransferFrame(data.data(), data.size(), &frame));
+  EXPECT_EQ(frame.value, uint64_t(1) << 20);
+  EXPECT_EQ(frame.payload_size, 4u);
+}
+
+TEST(DataTransferFraming, ParsesControlFrames) {
+  uint8_t data[kTransferControlHeaderSize] = {kTransferEnd};
+  WriteTransferUint32(data + 1, 0x01020304);
+  TransferFrame frame;
+  EXPECT_TRUE(ParseTransferFrame(data, sizeof(data), &frame));
+  EXPECT_EQ(frame.kind, kTransferEnd);
+  EXPECT_EQ(frame.id, 0x01020304u);
+  EXPECT_EQ(frame.payload_size, 0u);
+}
+
+TEST(DataTransferFraming, RejectsShortFrames) {
+  std::vector<uint8_t> data = Frame(kTransferChunk, 1, 0, 0);
+  TransferFrame frame;
+  for (size_t size = 0; size < kTransferChunkHeaderSize; size++)
+    EXPECT_FALSE(ParseTransferFrame(data.data(), size, &frame));
+  EXPECT_TRUE(ParseTransferFrame(data.data(), data.size(), &frame));
+
+  data = Frame(kTransferBegin, 1, 0, 0);
+  EXPECT_FALSE(
+      ParseTransferFrame(data.data(), kTransferChunkHeaderSize - 1, &frame));
+
+  data = Frame(kTransferAbort, 1, 0, 0);
+  EXPECT_FALSE(
+      ParseTransferFrame(data.data(), kTransferControlHeaderSize - 1, &frame));
+}
+
+TEST(DataTransferFraming, ChunkWithinTransfer) {
+  EXPECT_TRUE(TransferChunkFits(0, 100, 100));
+  EXPECT_TRUE(TransferChunkFits(60, 40, 100));
+  EXPECT_TRUE(TransferChunkFits(100, 0, 100));
+}
+
+TEST(DataTransferFraming, RejectsOversizedChunk) {
+  EXPECT_FALSE(TransferChunkFits(0, 101, 100));
+  EXPECT_FALSE(TransferChunkFits(0, 1, 0));
+}
+
+TEST(DataTransferFraming, RejectsOutOfRangeChunk) {
+  EXPECT_FALSE(TransferChunkFits(61, 40, 100));
+  EXPECT_FALSE(TransferChunkFits(101, 0, 100));
+  // offset + size would wrap around.
+  EXPECT_FALSE(TransferChunkFits(UINT64_MAX, 2, 100));
+  EXPECT_FALSE(TransferChunkFits(UINT64_MAX - 1, 10, UINT64_MAX));
+}
+
+TEST(DataTransferFraming, RoundTripsIntegers) {
+  uint8_t buffer[8];
+  WriteTransferUint64(buffer, 0x0102030405060708ull);
+  EXPECT_EQ(buffer[0], 0x08);
+  EXPECT_EQ(ReadTransferUint64(buffer), 0x0102030405060708ull);
+  WriteTransferUint32(buffer, 0xdeadbeef);
+  EXPECT_EQ(ReadTransferUint32(buffer), 0xdeadbeefu);
+}
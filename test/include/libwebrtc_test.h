@@ -0,0 +1,54 @@
+#ifndef LIB_WEBRTC_TEST_HXX
+#define LIB_WEBRTC_TEST_HXX
+
+#include <stdio.h>
+
+#include <vector>
+
+namespace libwebrtc_test {
+
+struct TestCase {
+  const char* name;
+  void (*run)();
+};
+
+inline std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+inline int& Failures() {
+  static int failures = 0;
+  return failures;
+}
+
+inline void Fail(const char* file, int line, const char* expression) {
+  fprintf(stderr, "%s:%d: expected %s\n", file, line, expression);
+  Failures()++;
+}
+
+struct Registrar {
+  Registrar(const char* name, void (*run)()) {
+    Registry().push_back({name, run});
+  }
+};
+
+}  // namespace libwebrtc_test
+
+#define TEST(suite, name)                                              \
+  static void suite##_##name();                                        \
+  static libwebrtc_test::Registrar suite##_##name##_registrar(         \
+      #suite "." #name, suite##_##name);                               \
+  static void suite##_##name()
+
+#define EXPECT_TRUE(condition)                                   \
+  do {                                                           \
+    if (!(condition))                                            \
+      libwebrtc_test::Fail(__FILE__, __LINE__, #condition);      \
+  } while (0)
+
+#define EXPECT_FALSE(condition) EXPECT_TRUE(!(condition))
+
+#define EXPECT_EQ(a, b) EXPECT_TRUE((a) == (b))
+
+#endif  // LIB_WEBRTC_TEST_HXX
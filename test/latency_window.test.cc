@@ -0,0 +1,55 @@
+#include "libwebrtc_test.h"
+#include "src/internal/latency_window.h"
+
+using namespace libwebrtc;
+
+TEST(LatencyWindow, EmptyWindow) {
+  LatencyWindow window(8);
+  RTCSetupLatencyStats stats = window.Stats();
+  EXPECT_EQ(stats.samples, 0u);
+  EXPECT_EQ(stats.p50_us, 0);
+  EXPECT_EQ(stats.max_us, 0);
+}
+
+TEST(LatencyWindow, PercentilesOfKnownValues) {
+  LatencyWindow window(1024);
+  // Added out of order, Stats() sorts.
+  for (int64_t i = 100; i >= 1; i--) window.Add(i);
+  RTCSetupLatencyStats stats = window.Stats();
+  EXPECT_EQ(stats.samples, 100u);
+  EXPECT_EQ(stats.p50_us, 50);
+  EXPECT_EQ(stats.p90_us, 90);
+  EXPECT_EQ(stats.p99_us, 99);
+  EXPECT_EQ(stats.max_us, 100);
+}
+
+TEST(LatencyWindow, SingleSample) {
+  LatencyWindow window(4);
+  window.Add(7);
+  RTCSetupLatencyStats stats = window.Stats();
+  EXPECT_EQ(stats.samples, 1u);
+  EXPECT_EQ(stats.p50_us, 7);
+  EXPECT_EQ(stats.p99_us, 7);
+  EXPECT_EQ(stats.max_us, 7);
+}
+
+TEST(LatencyWindow, WrapKeepsNewestSamples) {
+  LatencyWindow window(4);
+  window.Add(1000);
+  window.Add(900);
+  for (int64_t i = 1; i <= 4; i++) window.Add(i);
+  // 1000 and 900 were overwritten, the window holds 1..4.
+  RTCSetupLatencyStats stats = window.Stats();
+  EXPECT_EQ(stats.samples, 6u);
+  EXPECT_EQ(stats.p50_us, 2);
+  EXPECT_EQ(stats.p90_us, 4);
+  EXPECT_EQ(stats.max_us, 4);
+
+  // Wraps again past the start of the ring.
+  window.Add(10);
+  window.Add(20);
+  stats = window.Stats();
+  EXPECT_EQ(stats.samples, 8u);
+  EXPECT_EQ(stats.p50_us, 4);
+  EXPECT_EQ(stats.max_us, 20);
+}
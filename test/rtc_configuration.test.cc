@@ -0,0 +1,45 @@
+#include "libwebrtc_test.h"
+#include "rtc_types.h"
+
+using namespace libwebrtc;
+
+TEST(RTCConfiguration, DefaultsAreEqual) {
+  RTCConfiguration a;
+  RTCConfiguration b;
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a != b);
+}
+
+TEST(RTCConfiguration, ComparesIceServers) {
+  RTCConfiguration a;
+  RTCConfiguration b;
+  a.ice_servers[0].uri = string("stun:stun.example.org");
+  EXPECT_FALSE(a == b);
+  b.ice_servers[0].uri = string("stun:stun.example.org");
+  EXPECT_TRUE(a == b);
+  b.ice_servers[kMaxIceServerSize - 1].password = string("secret");
+  EXPECT_FALSE(a == b);
+}
+
+TEST(RTCConfiguration, ComparesScalarFields) {
+  RTCConfiguration base;
+  RTCConfiguration changed;
+  changed.ice_profile = RTCIceProfile::kFastConnect;
+  EXPECT_TRUE(base != changed);
+
+  changed = base;
+  changed.network_ignore_mask = 0;
+  EXPECT_TRUE(base != changed);
+
+  changed = base;
+  changed.sctp_max_message_size = 1024;
+  EXPECT_TRUE(base != changed);
+
+  changed = base;
+  changed.use_network_shard = true;
+  EXPECT_TRUE(base != changed);
+
+  changed = base;
+  changed.local_video_bandwidth = 0;
+  EXPECT_TRUE(base != changed);
+}
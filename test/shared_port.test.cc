@@ -0,0 +1,266 @@
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "libwebrtc.h"
+#include "libwebrtc_test.h"
+#include "rtc_data_channel.h"
+#include "rtc_ice_candidate.h"
+#include "rtc_mediaconstraints.h"
+#include "rtc_peerconnection.h"
+#include "rtc_peerconnection_factory.h"
+
+using namespace libwebrtc;
+
+namespace {
+
+constexpr uint16_t kSharedPort = 47011;
+constexpr int kPairs = 50;
+constexpr auto kTimeout = std::chrono::seconds(30);
+
+// Result of one asynchronous call, waited for on the test thread.
+struct Completion {
+  std::mutex mutex;
+  std::condition_variable done_changed;
+  bool done = false;
+  bool ok = false;
+  std::string sdp;
+  std::string type;
+
+  void Finish(bool succeeded, const std::string& description = "",
+              const std::string& description_type = "") {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    ok = succeeded;
+    sdp = description;
+    type = description_type;
+    done_changed.notify_all();
+  }
+
+  bool Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done_changed.wait_for(lock, kTimeout, [this] { return done; });
+    return done && ok;
+  }
+};
+
+// Counts the connection states of one side over all pairs.
+struct ConnectionCounter {
+  std::mutex mutex;
+  std::condition_variable changed;
+  int connected = 0;
+  int failed = 0;
+};
+
+class Endpoint : public RTCPeerConnectionObserver {
+ public:
+  explicit Endpoint(ConnectionCounter* counter) : counter_(counter) {}
+
+  void OnPeerConnectionState(RTCPeerConnectionState state) override {
+    if (!counter_) return;
+    std::lock_guard<std::mutex> lock(counter_->mutex);
+    if (state == RTCPeerConnectionStateConnected) counter_->connected++;
+    if (state == RTCPeerConnectionStateFailed) counter_->failed++;
+    counter_->changed.notify_all();
+  }
+
+  void OnIceGatheringState(RTCIceGatheringState state) override {
+    if (state == RTCIceGatheringStateComplete) gathered_.Finish(true);
+  }
+
+  bool WaitForGathering() { return gathered_.Wait(); }
+
+  void OnSignalingState(RTCSignalingState) override {}
+  void OnIceConnectionState(RTCIceConnectionState) override {}
+  // Descriptions are exchanged with all candidates once gathering is done.
+  void OnIceCandidate(scoped_refptr<RTCIceCandidate>) override {}
+  void OnAddStream(scoped_refptr<RTCMediaStream>) override {}
+  void OnRemoveStream(scoped_refptr<RTCMediaStream>) override {}
+  void OnDataChannel(scoped_refptr<RTCDataChannel>) override {}
+  void OnRenegotiationNeeded() override {}
+  void OnTrack(scoped_refptr<RTCRtpTransceiver>) override {}
+  void OnAddTrack(vector<scoped_refptr<RTCMediaStream>>,
+                  scoped_refptr<RTCRtpReceiver>) override {}
+  void OnRemoveTrack(scoped_refptr<RTCRtpReceiver>) override {}
+
+ private:
+  ConnectionCounter* counter_;
+  Completion gathered_;
+};
+
+bool CreateDescription(scoped_refptr<RTCPeerConnection> peerconnection,
+                       bool offer, std::string* sdp, std::string* type) {
+  Completion created;
+  Completion* raw = &created;
+  auto success = [raw](const string description, const string kind) {
+    raw->Finish(true, description.std_string(), kind.std_string());
+  };
+  auto failure = [raw](const char*) { raw->Finish(false); };
+  if (offer) {
+    peerconnection->CreateOffer(success, failure,
+                                RTCMediaConstraints::Create());
+  } else {
+    peerconnection->CreateAnswer(success, failure,
+                                 RTCMediaConstraints::Create());
+  }
+  if (!created.Wait()) return false;
+  *sdp = created.sdp;
+  *type = created.type;
+  return true;
+}
+
+bool SetDescription(scoped_refptr<RTCPeerConnection> peerconnection,
+                    bool local, const std::string& sdp,
+                    const std::string& type) {
+  Completion applied;
+  Completion* raw = &applied;
+  auto success = [raw]() { raw->Finish(true); };
+  auto failure = [raw](const char*) { raw->Finish(false); };
+  if (local) {
+    peerconnection->SetLocalDescription(string(sdp), string(type), success,
+                                        failure);
+  } else {
+    peerconnection->SetRemoteDescription(string(sdp), string(type), success,
+                                         failure);
+  }
+  return applied.Wait();
+}
+
+// Local description with every gathered candidate.
+bool GatheredDescription(scoped_refptr<RTCPeerConnection> peerconnection,
+                         Endpoint* endpoint, std::string* sdp) {
+  if (!endpoint->WaitForGathering()) return false;
+  Completion described;
+  Completion* raw = &described;
+  peerconnection->GetLocalDescription(
+      [raw](const char* description, const char* type) {
+        raw->Finish(true, description, type);
+      },
+      [raw](const char*) { raw->Finish(false); });
+  if (!described.Wait()) return false;
+  *sdp = described.sdp;
+  return true;
+}
+
+// "a=candidate:<foundation> <component> <protocol> <priority> <address>
+// <port> typ <type> ..." lines of |sdp|.
+std::vector<std::vector<std::string>> Candidates(const std::string& sdp) {
+  std::vector<std::vector<std::string>> candidates;
+  std::istringstream lines(sdp);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, 12, "a=candidate:") != 0) continue;
+    std::istringstream fields(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (fields >> token) tokens.push_back(token);
+    candidates.push_back(tokens);
+  }
+  return candidates;
+}
+
+}  // namespace
+
+// Connects many client connections to server connections that all share
+// one UDP port in ICE-lite mode, in one process.
+TEST(SharedUdpPort, ConnectsManyPeersThroughOnePort) {
+  EXPECT_TRUE(LibWebRTC::Initialize());
+
+  RTCPeerConnectionFactoryOptions server_options;
+  server_options.shared_udp_port = kSharedPort;
+  server_options.ice_lite = true;
+  scoped_refptr<RTCPeerConnectionFactory> server_factory =
+      LibWebRTC::CreateRTCPeerConnectionFactory(server_options);
+  scoped_refptr<RTCPeerConnectionFactory> client_factory =
+      LibWebRTC::CreateRTCPeerConnectionFactory();
+  EXPECT_TRUE(server_factory.get() != nullptr);
+  EXPECT_TRUE(client_factory.get() != nullptr);
+  if (!server_factory || !client_factory) return;
+
+  ConnectionCounter server_connections;
+  std::vector<std::unique_ptr<Endpoint>> endpoints;
+  std::vector<scoped_refptr<RTCPeerConnection>> servers;
+  std::vector<scoped_refptr<RTCPeerConnection>> clients;
+  int negotiated = 0;
+  int lite_answers = 0;
+  int server_candidates = 0;
+  int candidates_on_shared_port = 0;
+
+  RTCConfiguration configuration;
+  for (int i = 0; i < kPairs; i++) {
+    endpoints.push_back(std::make_unique<Endpoint>(&server_connections));
+    Endpoint* server_endpoint = endpoints.back().get();
+    endpoints.push_back(std::make_unique<Endpoint>(nullptr));
+    Endpoint* client_endpoint = endpoints.back().get();
+
+    scoped_refptr<RTCPeerConnection> server = server_factory->Create(
+        configuration, RTCMediaConstraints::Create());
+    scoped_refptr<RTCPeerConnection> client = client_factory->Create(
+        configuration, RTCMediaConstraints::Create());
+    if (!server || !client) continue;
+    servers.push_back(server);
+    clients.push_back(client);
+    server->RegisterRTCPeerConnectionObserver(server_endpoint);
+    client->RegisterRTCPeerConnectionObserver(client_endpoint);
+
+    RTCDataChannelInit init;
+    client->CreateDataChannel(string("load"), &init);
+
+    std::string sdp;
+    std::string type;
+    if (!CreateDescription(client, true, &sdp, &type) ||
+        !SetDescription(client, true, sdp, type) ||
+        !GatheredDescription(client, client_endpoint, &sdp) ||
+        !SetDescription(server, false, sdp, type) ||
+        !CreateDescription(server, false, &sdp, &type) ||
+        !SetDescription(server, true, sdp, type) ||
+        !GatheredDescription(server, server_endpoint, &sdp) ||
+        !SetDescription(client, false, sdp, type))
+      continue;
+    negotiated++;
+    if (sdp.find("a=ice-lite") != std::string::npos) lite_answers++;
+    for (const std::vector<std::string>& candidate : Candidates(sdp)) {
+      server_candidates++;
+      if (candidate.size() > 7 && candidate[5] == std::to_string(kSharedPort) &&
+          candidate[7] == "host")
+        candidates_on_shared_port++;
+    }
+  }
+
+  EXPECT_EQ(negotiated, kPairs);
+  EXPECT_EQ(lite_answers, kPairs);
+  EXPECT_TRUE(server_candidates >= kPairs);
+  EXPECT_EQ(candidates_on_shared_port, server_candidates);
+
+  {
+    std::unique_lock<std::mutex> lock(server_connections.mutex);
+    server_connections.changed.wait_for(lock, kTimeout, [&] {
+      return server_connections.connected + server_connections.failed >=
+             kPairs;
+    });
+    EXPECT_EQ(server_connections.connected, kPairs);
+    EXPECT_EQ(server_connections.failed, 0);
+  }
+
+  for (scoped_refptr<RTCPeerConnection> server : servers) {
+    server->DeRegisterRTCPeerConnectionObserver();
+    server->Close();
+    server_factory->Delete(server);
+  }
+  for (scoped_refptr<RTCPeerConnection> client : clients) {
+    client->DeRegisterRTCPeerConnectionObserver();
+    client->Close();
+    client_factory->Delete(client);
+  }
+  servers.clear();
+  clients.clear();
+  server_factory->Terminate();
+  client_factory->Terminate();
+  server_factory = nullptr;
+  client_factory = nullptr;
+  LibWebRTC::Terminate();
+}
@@ -0,0 +1,99 @@
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "libwebrtc_test.h"
+#include "src/internal/stun_peek.h"
+
+using namespace libwebrtc;
+
+static void AppendUint16(std::vector<uint8_t>* out, uint16_t value) {
+  out->push_back(static_cast<uint8_t>(value >> 8));
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+// Binding message of |type| with the given attributes, each padded to 4
+// bytes.
+static std::vector<uint8_t> StunMessage(
+    uint16_t type, const std::vector<std::pair<uint16_t, std::string>>&
+                       attributes) {
+  std::vector<uint8_t> body;
+  for (const auto& attribute : attributes) {
+    AppendUint16(&body, attribute.first);
+    AppendUint16(&body, static_cast<uint16_t>(attribute.second.size()));
+    body.insert(body.end(), attribute.second.begin(), attribute.second.end());
+    while (body.size() % 4 != 0) body.push_back(0);
+  }
+  std::vector<uint8_t> message;
+  AppendUint16(&message, type);
+  AppendUint16(&message, static_cast<uint16_t>(body.size()));
+  message.push_back(0x21);
+  message.push_back(0x12);
+  message.push_back(0xA4);
+  message.push_back(0x42);
+  for (uint8_t i = 0; i < 12; i++) message.push_back('a' + i);
+  message.insert(message.end(), body.begin(), body.end());
+  return message;
+}
+
+TEST(StunPeek, ReadsBindingRequest) {
+  // PRIORITY precedes USERNAME, as in native checks.
+  std::vector<uint8_t> message = StunMessage(
+      0x0001, {{0x0024, std::string(4, '\x01')}, {0x0006, "srv1:cli"}});
+  StunPeek peek;
+  EXPECT_TRUE(PeekStun(message.data(), message.size(), &peek));
+  EXPECT_TRUE(peek.request);
+  EXPECT_FALSE(peek.response);
+  EXPECT_EQ(peek.transaction_id, std::string("abcdefghijkl"));
+  EXPECT_EQ(peek.username, std::string("srv1:cli"));
+  EXPECT_EQ(ReceiverUfrag(peek.username), std::string("srv1"));
+  EXPECT_EQ(SenderUfrag(peek.username), std::string("cli"));
+}
+
+TEST(StunPeek, ReadsResponses) {
+  StunPeek peek;
+  std::vector<uint8_t> success = StunMessage(0x0101, {});
+  EXPECT_TRUE(PeekStun(success.data(), success.size(), &peek));
+  EXPECT_FALSE(peek.request);
+  EXPECT_TRUE(peek.response);
+  EXPECT_TRUE(peek.username.empty());
+
+  std::vector<uint8_t> error = StunMessage(0x0111, {});
+  EXPECT_TRUE(PeekStun(error.data(), error.size(), &peek));
+  EXPECT_TRUE(peek.response);
+
+  std::vector<uint8_t> indication = StunMessage(0x0011, {});
+  EXPECT_TRUE(PeekStun(indication.data(), indication.size(), &peek));
+  EXPECT_FALSE(peek.request);
+  EXPECT_FALSE(peek.response);
+}
+
+TEST(StunPeek, RejectsOtherProtocols) {
+  StunPeek peek;
+  std::vector<uint8_t> message = StunMessage(0x0001, {{0x0006, "a:b"}});
+
+  std::vector<uint8_t> truncated(message.begin(), message.end() - 4);
+  EXPECT_FALSE(PeekStun(truncated.data(), truncated.size(), &peek));
+
+  std::vector<uint8_t> no_cookie = message;
+  no_cookie[4] = 0;
+  EXPECT_FALSE(PeekStun(no_cookie.data(), no_cookie.size(), &peek));
+
+  // RTP version 2 sets the top bits.
+  std::vector<uint8_t> rtp = message;
+  rtp[0] = 0x80;
+  EXPECT_FALSE(PeekStun(rtp.data(), rtp.size(), &peek));
+
+  // Attribute running past the end of the message.
+  std::vector<uint8_t> overrun = StunMessage(0x0001, {{0x0024, "abcd"}});
+  overrun[23] = 8;
+  EXPECT_FALSE(PeekStun(overrun.data(), overrun.size(), &peek));
+}
+
+TEST(StunPeek, UfragsNeedAColon) {
+  EXPECT_TRUE(ReceiverUfrag("nocolon").empty());
+  EXPECT_TRUE(SenderUfrag("nocolon").empty());
+  EXPECT_EQ(ReceiverUfrag(":x"), std::string());
+  EXPECT_EQ(SenderUfrag("x:"), std::string());
+}
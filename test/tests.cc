@@ -0,0 +1,15 @@
+#include "libwebrtc_test.h"
+
+int main() {
+  int failed_tests = 0;
+  for (const libwebrtc_test::TestCase& test : libwebrtc_test::Registry()) {
+    int failures = libwebrtc_test::Failures();
+    test.run();
+    bool passed = libwebrtc_test::Failures() == failures;
+    printf("[%s] %s\n", passed ? "  OK  " : "FAILED", test.name);
+    if (!passed) failed_tests++;
+  }
+  printf("%d of %zu tests failed\n", failed_tests,
+         libwebrtc_test::Registry().size());
+  return failed_tests == 0 ? 0 : 1;
+}
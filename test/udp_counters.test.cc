@@ -0,0 +1,79 @@
+#include <sstream>
+
+#include "libwebrtc_test.h"
+#include "src/internal/udp_counters.h"
+
+using namespace libwebrtc;
+
+TEST(UdpCounters, ParsesSnmp) {
+  std::istringstream snmp(
+      "Ip: Forwarding DefaultTTL\n"
+      "Ip: 1 64\n"
+      "Udp: InDatagrams NoPorts InErrors OutDatagrams RcvbufErrors "
+      "SndbufErrors InCsumErrors IgnoredMulti MemErrors\n"
+      "Udp: 1000 5 42 900 40 2 0 0 0\n"
+      "UdpLite: InDatagrams NoPorts InErrors OutDatagrams\n"
+      "UdpLite: 7 7 7 7\n");
+  RTCUdpDropCounters counters;
+  EXPECT_TRUE(ParseSnmpUdp(snmp, &counters));
+  EXPECT_EQ(counters.in_datagrams, 1000u);
+  EXPECT_EQ(counters.out_datagrams, 900u);
+  EXPECT_EQ(counters.in_errors, 42u);
+  EXPECT_EQ(counters.receive_buffer_errors, 40u);
+  EXPECT_EQ(counters.send_buffer_errors, 2u);
+}
+
+TEST(UdpCounters, ParsesSnmp6) {
+  std::istringstream snmp6(
+      "Ip6InReceives 123\n"
+      "Udp6InDatagrams 300\n"
+      "Udp6NoPorts 1\n"
+      "Udp6InErrors 8\n"
+      "Udp6OutDatagrams 200\n"
+      "Udp6RcvbufErrors 7\n"
+      "Udp6SndbufErrors 1\n"
+      "UdpLite6InDatagrams 9\n");
+  RTCUdpDropCounters counters;
+  EXPECT_TRUE(ParseSnmp6Udp(snmp6, &counters));
+  EXPECT_EQ(counters.in_datagrams, 300u);
+  EXPECT_EQ(counters.out_datagrams, 200u);
+  EXPECT_EQ(counters.in_errors, 8u);
+  EXPECT_EQ(counters.receive_buffer_errors, 7u);
+  EXPECT_EQ(counters.send_buffer_errors, 1u);
+}
+
+TEST(UdpCounters, SumsBothFamilies) {
+  std::istringstream snmp(
+      "Udp: InDatagrams RcvbufErrors\n"
+      "Udp: 10 1\n");
+  std::istringstream snmp6(
+      "Udp6InDatagrams 5\n"
+      "Udp6RcvbufErrors 2\n");
+  RTCUdpDropCounters counters;
+  EXPECT_TRUE(ParseSnmpUdp(snmp, &counters));
+  EXPECT_TRUE(ParseSnmp6Udp(snmp6, &counters));
+  EXPECT_EQ(counters.in_datagrams, 15u);
+  EXPECT_EQ(counters.receive_buffer_errors, 3u);
+}
+
+TEST(UdpCounters, MissingSectionsReturnFalse) {
+  std::istringstream empty("");
+  std::istringstream names_only("Udp: InDatagrams OutDatagrams\n");
+  std::istringstream no_udp6("Ip6InReceives 1\n");
+  RTCUdpDropCounters counters;
+  EXPECT_FALSE(ParseSnmpUdp(empty, &counters));
+  EXPECT_FALSE(ParseSnmpUdp(names_only, &counters));
+  EXPECT_FALSE(ParseSnmp6Udp(no_udp6, &counters));
+  EXPECT_EQ(counters.in_datagrams, 0u);
+}
+
+TEST(UdpCounters, StopsAtTruncatedValues) {
+  std::istringstream snmp(
+      "Udp: InDatagrams InErrors OutDatagrams\n"
+      "Udp: 10 3\n");
+  RTCUdpDropCounters counters;
+  EXPECT_TRUE(ParseSnmpUdp(snmp, &counters));
+  EXPECT_EQ(counters.in_datagrams, 10u);
+  EXPECT_EQ(counters.in_errors, 3u);
+  EXPECT_EQ(counters.out_datagrams, 0u);
+}